@@ -0,0 +1,120 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMAxisBatch.h"
+
+#include <OISJoyStick.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define OISM_AXIS_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+
+using namespace oism;
+
+
+void AxisBatch::clear()
+{
+    mLanes.clear();
+    mRaw.clear();
+    mDeadZone.clear();
+    mScale.clear();
+    mThreshold.clear();
+    mValues.clear();
+    mChanged.clear();
+}
+
+
+void AxisBatch::addLane(unsigned joystick, unsigned axis, float deadZone, float threshold)
+{
+    unsigned lane = mLanes.size();
+    mLanes.push_back({joystick, axis});
+
+    unsigned padded = (mLanes.size() + 3) & ~3u;
+    mRaw.resize(padded, 0);
+    mDeadZone.resize(padded, 0.f);
+    mScale.resize(padded, 1.f);
+    mThreshold.resize(padded, 0.f);
+    mValues.resize(padded, 0.f);
+    mChanged.reserve(padded);
+
+    deadZone = std::max(0.f, std::min(deadZone, 1.f));
+    mDeadZone[lane] = deadZone;
+    mScale[lane] = deadZone < 1.f ? 1.f / (1.f - deadZone) : 0.f;
+    mThreshold[lane] = threshold;
+}
+
+
+unsigned AxisBatch::process()
+{
+    mChanged.clear();
+#ifdef OISM_AXIS_BATCH_SSE
+    const __m128 norm = _mm_set1_ps(1.f / OIS::JoyStick::MAX_AXIS);
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+
+    for (unsigned i = 0; i < mRaw.size(); i += 4)
+    {
+        __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&mRaw[i])), norm);
+        __m128 sign = _mm_and_ps(x, signMask);
+        __m128 magnitude = _mm_andnot_ps(signMask, x);
+
+        // Dead zone, rescale and clamp
+        magnitude = _mm_sub_ps(magnitude, _mm_loadu_ps(&mDeadZone[i]));
+        magnitude = _mm_mul_ps(_mm_max_ps(magnitude, zero), _mm_loadu_ps(&mScale[i]));
+        magnitude = _mm_min_ps(magnitude, one);
+        __m128 value = _mm_or_ps(magnitude, sign);
+
+        // Changed past the threshold, or settled at the center or an end
+        __m128 last = _mm_loadu_ps(&mValues[i]);
+        __m128 diff = _mm_andnot_ps(signMask, _mm_sub_ps(value, last));
+        __m128 significant = _mm_or_ps(_mm_cmpge_ps(diff, _mm_loadu_ps(&mThreshold[i])),
+                             _mm_or_ps(_mm_cmpeq_ps(magnitude, zero), _mm_cmpeq_ps(magnitude, one)));
+        __m128 changed = _mm_and_ps(_mm_cmpneq_ps(value, last), significant);
+
+        int mask = _mm_movemask_ps(changed);
+        if (!mask) continue;
+        _mm_storeu_ps(&mValues[i], _mm_or_ps(_mm_and_ps(changed, value), _mm_andnot_ps(changed, last)));
+        for (unsigned lane = 0; lane < 4; lane++)
+            if (mask & (1 << lane)) mChanged.push_back(i + lane);
+    }
+
+    // Padding lanes are 0 and never differ from their last value
+    return mChanged.size();
+#else
+    _processLanes(0, mRaw.size());
+    return mChanged.size();
+#endif
+}
+
+
+unsigned AxisBatch::_processScalar()
+{
+    mChanged.clear();
+    _processLanes(0, mRaw.size());
+    return mChanged.size();
+}
+
+
+void AxisBatch::_processLanes(unsigned begin, unsigned end)
+{
+    const float norm = 1.f / OIS::JoyStick::MAX_AXIS;
+    for (unsigned i = begin; i < end; i++)
+    {
+        float x = mRaw[i] * norm;
+        float magnitude = std::min(std::max(std::fabs(x) - mDeadZone[i], 0.f) * mScale[i], 1.f);
+        float value = x < 0.f ? -magnitude : magnitude;
+
+        float last = mValues[i];
+        bool significant = std::fabs(value - last) >= mThreshold[i] || magnitude == 0.f || magnitude == 1.f;
+        if (value == last || !significant) continue;
+
+        mValues[i] = value;
+        mChanged.push_back(i);
+    }
+}
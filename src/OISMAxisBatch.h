@@ -0,0 +1,57 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <vector>
+
+
+namespace oism
+{
+
+
+//! Joystick axes of every device normalized, filtered and compared to the
+//! previous values in one pass, with SSE when available.
+//! Lanes are set with 'addLane()', raw values written with 'setRaw()'
+//! before each 'process()'.
+class AxisBatch
+{
+public:
+    struct Lane
+    {
+        unsigned joystick;
+        unsigned axis;
+    };
+
+    void clear();
+    /// 'deadZone' and 'threshold' are normalized, see 'Handler::Configuration::AxisFilter'
+    void addLane(unsigned joystick, unsigned axis, float deadZone, float threshold);
+
+    unsigned size() const { return mLanes.size(); }
+    const Lane& getLane(unsigned lane) const { return mLanes[lane]; }
+
+    void setRaw(unsigned lane, int value) { mRaw[lane] = value; }
+
+    /// Normalize, apply the dead zone and clamp every lane. Return the number of
+    /// lanes whose value changed, listed by 'getChanged()'.
+    unsigned process();
+    unsigned _processScalar(); //!< Reference implementation
+
+    const std::vector<unsigned>& getChanged() const { return mChanged; }
+    float getValue(unsigned lane) const { return mValues[lane]; }
+
+private:
+    void _processLanes(unsigned begin, unsigned end);
+
+    std::vector<Lane> mLanes;
+    // Padded to a multiple of 4 lanes, padding lanes never change
+    std::vector<int> mRaw;
+    std::vector<float> mDeadZone;
+    std::vector<float> mScale; //!< Rescale what is past the dead zone to [0, 1]
+    std::vector<float> mThreshold;
+    std::vector<float> mValues; //!< Last dispatched
+    std::vector<unsigned> mChanged;
+};
+
+
+} // namespace oism
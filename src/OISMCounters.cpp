@@ -0,0 +1,98 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMCounters.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+
+using namespace oism;
+using namespace oism::counters;
+
+
+const char* counters::to_string(Counter c)
+{
+    switch (c)
+    {
+        case CNT_KEYBOARD_EVENTS: return "keyboard_events";
+        case CNT_MOUSE_EVENTS: return "mouse_events";
+        case CNT_JOYSTICK_EVENTS: return "joystick_events";
+        case CNT_DISPATCH_PROBES: return "dispatch_probes";
+        case CNT_DISPATCH_MISSES: return "dispatch_misses";
+        case CNT_SET_VALUE_NOOPS: return "set_value_noops";
+        case CNT_CALLBACKS_FIRED: return "callbacks_fired";
+        case CNT_CALLBACKS_REMOVED: return "callbacks_removed";
+        case CNT_REBUILDS: return "rebuilds";
+        case CNT_COUNT: break;
+    }
+    return "";
+}
+
+
+#ifdef OISM_ENABLE_COUNTERS
+
+
+namespace
+{
+
+    struct Registry
+    {
+        Registry() { std::fill(retired, retired + CNT_COUNT, 0ull); }
+
+        std::mutex mutex;
+        std::vector<Block*> blocks;
+        unsigned long long retired[CNT_COUNT];
+    };
+
+    // Never destroyed, thread blocks may outlive static objects
+    Registry& registry()
+    {
+        static Registry* r = new Registry();
+        return *r;
+    }
+
+} // namespace
+
+
+Block::Block()
+{
+    for (auto& count : counts) count.store(0, std::memory_order_relaxed);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.blocks.push_back(this);
+}
+
+
+Block::~Block()
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (unsigned i = 0; i < CNT_COUNT; i++) r.retired[i] += counts[i].load(std::memory_order_relaxed);
+    r.blocks.erase(std::find(r.blocks.begin(), r.blocks.end(), this));
+}
+
+
+unsigned long long counters::get(Counter c)
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    unsigned long long total = r.retired[c];
+    for (auto b : r.blocks) total += b->counts[c].load(std::memory_order_relaxed);
+    return total;
+}
+
+
+void counters::reset()
+{
+    // Counts added meanwhile by other threads may be lost
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& count : r.retired) count = 0;
+    for (auto b : r.blocks)
+        for (auto& count : b->counts) count.store(0, std::memory_order_relaxed);
+}
+
+
+#endif // OISM_ENABLE_COUNTERS
@@ -0,0 +1,67 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <atomic>
+
+
+namespace oism
+{
+
+
+namespace counters
+{
+
+    enum Counter
+    {
+        CNT_KEYBOARD_EVENTS, //!< Device events received
+        CNT_MOUSE_EVENTS,
+        CNT_JOYSTICK_EVENTS,
+        CNT_DISPATCH_PROBES, //!< Dispatch table lookups
+        CNT_DISPATCH_MISSES, //!< Lookups of an unbound slot
+        CNT_SET_VALUE_NOOPS, //!< Source already at the value
+        CNT_CALLBACKS_FIRED,
+        CNT_CALLBACKS_REMOVED, //!< Released handles erased from the lists
+        CNT_REBUILDS, //!< '_buildBindingListMaps()' calls
+        CNT_COUNT
+    };
+
+#ifdef OISM_ENABLE_COUNTERS
+    //! Counters of one thread, alone on its cache lines.
+    //! Only the owning thread write, other threads read when aggregating.
+    struct alignas(64) Block
+    {
+        Block();
+        ~Block(); //!< Keep the counts of exited threads
+
+        std::atomic<unsigned long long> counts[CNT_COUNT];
+    };
+
+    inline Block& block()
+    {
+        static thread_local Block b;
+        return b;
+    }
+
+    inline void add(Counter c, unsigned long long n = 1)
+    {
+        auto& count = block().counts[c];
+        count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /// Sum of every thread
+    unsigned long long get(Counter c);
+    void reset();
+#else // OISM_ENABLE_COUNTERS
+    inline void add(Counter c, unsigned long long n = 1) {}
+    inline unsigned long long get(Counter c) { return 0; }
+    inline void reset() {}
+#endif // OISM_ENABLE_COUNTERS
+
+    const char* to_string(Counter c);
+
+} // namespace counters
+
+
+} // namespace oism
@@ -0,0 +1,321 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMDeviceBackend.h"
+#include "OISMHandler.h"
+
+#include <algorithm>
+
+#if defined OIS_LINUX_PLATFORM
+#include <dirent.h>
+#include <sys/stat.h>
+#include <X11/Xlib.h>
+#endif
+
+
+using namespace oism;
+
+
+/*
+=====================
+DeviceBackend
+=====================
+*/
+
+
+std::vector<OIS::JoyStick*> DeviceBackend::createJoySticks(unsigned long windowID, const std::vector<std::string>& identities)
+{
+    return std::vector<OIS::JoyStick*>(identities.size(), nullptr);
+}
+
+
+std::vector<std::string> DeviceBackend::makeJoyStickIdentities(const std::vector<std::string>& vendors)
+{
+    std::vector<std::string> identities;
+    std::unordered_map<std::string, unsigned> ordinals;
+    for (auto& vendor : vendors) identities.push_back(vendor+"#"+std::to_string(ordinals[vendor]++));
+    return identities;
+}
+
+
+/*
+=====================
+OISBackend
+=====================
+*/
+
+
+namespace
+{
+
+std::vector<std::string> listJoyStickVendors(OIS::InputManager* ois)
+{
+    std::vector<std::string> vendors;
+    for (auto& dev : ois->listFreeDevices())
+        if (dev.first == OIS::OISJoyStick) vendors.push_back(dev.second);
+    return vendors;
+}
+
+#if defined OIS_LINUX_PLATFORM
+// Name and inode of each node, a replugged device get a new one
+std::vector<std::string> listInputNodes()
+{
+    std::vector<std::string> nodes;
+    DIR* dir = opendir("/dev/input");
+    if (!dir) return nodes;
+
+    while (dirent* entry = readdir(dir))
+    {
+        struct stat st;
+        std::string path = std::string("/dev/input/")+entry->d_name;
+        if (stat(path.c_str(), &st) != 0) continue;
+        nodes.push_back(path+":"+std::to_string(st.st_ino));
+    }
+    closedir(dir);
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+#endif
+
+} // namespace
+
+
+OISBackend::OISBackend()
+:   mDisplay(nullptr),
+    mBlankCursor(0),
+    mJoyStickListed(false)
+{
+}
+
+
+OISBackend::~OISBackend()
+{
+    for (auto& pair : mJoyStickSystems) pair.second->destroyInputObject(pair.first);
+    for (auto& pair : mJoyStickCounts) OIS::InputManager::destroyInputSystem(pair.first);
+
+#if defined OIS_LINUX_PLATFORM
+    if (!mDisplay) return;
+    XFreeCursor(mDisplay, mBlankCursor);
+    XCloseDisplay(mDisplay);
+#endif
+}
+
+
+DeviceSet OISBackend::create(unsigned long windowID, bool exclusive, bool verbose, bool joySticks)
+{
+    OIS::ParamList pl;
+    pl.insert({"WINDOW", std::to_string(windowID)});
+
+    if (!exclusive)
+    {
+#if defined OIS_WIN32_PLATFORM
+        pl.insert({"w32_mouse",    "DISCL_FOREGROUND"});
+        pl.insert({"w32_mouse",    "DISCL_NONEXCLUSIVE"});
+        pl.insert({"w32_keyboard", "DISCL_FOREGROUND"});
+        pl.insert({"w32_keyboard", "DISCL_NONEXCLUSIVE"});
+#elif defined OIS_LINUX_PLATFORM
+        pl.insert({"x11_mouse_grab",    "false"});
+        pl.insert({"x11_mouse_hide",    "false"});
+        pl.insert({"x11_keyboard_grab", "false"});
+        pl.insert({"XAutoRepeatOn",     "true"});
+#endif
+    }
+
+    DeviceSet devices;
+    devices.exclusive = exclusive;
+    devices.ois = OIS::InputManager::createInputSystem(pl);
+    OIS::InputManager* ois = devices.ois;
+
+    if (verbose)
+    {
+        log::log(log::Level::Info, ois->inputSystemName());
+        log::log(log::Level::Info, "Available device:");
+        for (auto& dev : ois->listFreeDevices())
+            log::log(log::Level::Info, "  - ", Handler::convertOISDeviceTypeToString(dev.first), " (", dev.second, ")");
+    }
+
+    // Create devices
+
+    if (ois->getNumberOfDevices(OIS::OISMouse))
+        devices.mouse = static_cast<OIS::Mouse*>(ois->createInputObject(OIS::OISMouse, true));
+
+    if (ois->getNumberOfDevices(OIS::OISKeyboard))
+        devices.keyboard = static_cast<OIS::Keyboard*>(ois->createInputObject(OIS::OISKeyboard, true));
+
+    unsigned numJoystick = joySticks ? ois->getNumberOfDevices(OIS::OISJoyStick) : 0;
+    if (numJoystick && verbose) log::log(log::Level::Info, "Creating joystick:");
+
+    for (unsigned i = 0; i < numJoystick; i++)
+    {
+        auto js = static_cast<OIS::JoyStick*>(ois->createInputObject(OIS::OISJoyStick, true));
+        devices.joySticks.push_back(js);
+        if (!verbose) continue;
+
+        // List specs
+        log::log(log::Level::Info, "  - Joystick ", i, " -- Vendor: ", js->vendor());
+        log::log(log::Level::Info, "    - Unknown: ", js->getNumberOfComponents(OIS::ComponentType::OIS_Unknown));
+        log::log(log::Level::Info, "    - Button: ", js->getNumberOfComponents(OIS::ComponentType::OIS_Button));
+        log::log(log::Level::Info, "    - Axis: ", js->getNumberOfComponents(OIS::ComponentType::OIS_Axis));
+        log::log(log::Level::Info, "    - Slider: ", js->getNumberOfComponents(OIS::ComponentType::OIS_Slider));
+        log::log(log::Level::Info, "    - POV: ", js->getNumberOfComponents(OIS::ComponentType::OIS_POV));
+        log::log(log::Level::Info, "    - Movement capture: ", js->getNumberOfComponents(OIS::ComponentType::OIS_Vector3));
+    }
+
+    return devices;
+}
+
+
+void OISBackend::destroy(DeviceSet& devices)
+{
+    if (!devices.ois) return;
+
+    devices.ois->destroyInputObject(devices.keyboard);
+    devices.ois->destroyInputObject(devices.mouse);
+    for (auto js : devices.joySticks) devices.ois->destroyInputObject(js);
+
+    OIS::InputManager::destroyInputSystem(devices.ois);
+    devices = DeviceSet();
+}
+
+
+bool OISBackend::setExclusive(const DeviceSet& devices, unsigned long windowID, bool exclusive)
+{
+#if defined OIS_LINUX_PLATFORM
+    // OIS grabs on its own connection, released only with its devices
+    if (devices.exclusive || !devices.ois || !windowID) return false;
+
+    if (!mDisplay)
+    {
+        mDisplay = XOpenDisplay(nullptr);
+        if (!mDisplay) return false;
+
+        char empty = 0;
+        XColor black = {};
+        Pixmap pixmap = XCreateBitmapFromData(mDisplay, windowID, &empty, 1, 1);
+        mBlankCursor = XCreatePixmapCursor(mDisplay, pixmap, pixmap, &black, &black, 0, 0);
+        XFreePixmap(mDisplay, pixmap);
+    }
+
+    if (!exclusive)
+    {
+        XUngrabPointer(mDisplay, CurrentTime);
+        XUngrabKeyboard(mDisplay, CurrentTime);
+        XUndefineCursor(mDisplay, windowID);
+        XAutoRepeatOn(mDisplay);
+        XFlush(mDisplay);
+        return true;
+    }
+
+    if (devices.mouse && XGrabPointer(mDisplay, windowID, True, 0, GrabModeAsync, GrabModeAsync,
+        windowID, None, CurrentTime) != GrabSuccess) return false;
+    if (devices.keyboard && XGrabKeyboard(mDisplay, windowID, True, GrabModeAsync, GrabModeAsync,
+        CurrentTime) != GrabSuccess)
+    {
+        XUngrabPointer(mDisplay, CurrentTime);
+        XFlush(mDisplay);
+        return false;
+    }
+    if (devices.mouse) XDefineCursor(mDisplay, windowID, mBlankCursor);
+    if (devices.keyboard) XAutoRepeatOff(mDisplay);
+    XFlush(mDisplay);
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool OISBackend::isThreadSafe() const
+{
+#if defined OIS_LINUX_PLATFORM
+    return false;
+#else
+    return true;
+#endif
+}
+
+
+bool OISBackend::listJoySticks(unsigned long windowID, std::vector<std::string>& identities)
+{
+    std::lock_guard<std::mutex> lock(mJoyStickMutex);
+
+#if defined OIS_LINUX_PLATFORM
+    // Enumerated again only when a device node change
+    std::vector<std::string> nodes = listInputNodes();
+    if (mJoyStickListed && nodes == mJoyStickNodes)
+    {
+        identities = mJoyStickIdentities;
+        return true;
+    }
+    mJoyStickNodes.swap(nodes);
+#endif
+
+    OIS::ParamList pl;
+    pl.insert({"WINDOW", std::to_string(windowID)});
+    OIS::InputManager* ois = OIS::InputManager::createInputSystem(pl);
+    mJoyStickIdentities = makeJoyStickIdentities(listJoyStickVendors(ois));
+    OIS::InputManager::destroyInputSystem(ois);
+
+    mJoyStickListed = true;
+    identities = mJoyStickIdentities;
+    return true;
+}
+
+
+std::vector<OIS::JoyStick*> OISBackend::createJoySticks(unsigned long windowID, const std::vector<std::string>& identities)
+{
+    std::vector<OIS::JoyStick*> joySticks(identities.size(), nullptr);
+
+    OIS::ParamList pl;
+    pl.insert({"WINDOW", std::to_string(windowID)});
+    OIS::InputManager* ois = OIS::InputManager::createInputSystem(pl);
+
+    // Objects are created in enumeration order, those not requested are destroyed
+    std::vector<OIS::JoyStick*> unused;
+    try
+    {
+        for (auto& identity : makeJoyStickIdentities(listJoyStickVendors(ois)))
+        {
+            auto js = static_cast<OIS::JoyStick*>(ois->createInputObject(OIS::OISJoyStick, true));
+            auto it = std::find(identities.begin(), identities.end(), identity);
+            if (it == identities.end()) unused.push_back(js);
+            else joySticks[it - identities.begin()] = js;
+        }
+    }
+    catch (...)
+    {
+        for (auto js : joySticks) if (js) ois->destroyInputObject(js);
+        for (auto js : unused) ois->destroyInputObject(js);
+        OIS::InputManager::destroyInputSystem(ois);
+        throw;
+    }
+    for (auto js : unused) ois->destroyInputObject(js);
+
+    unsigned count = identities.size() - std::count(joySticks.begin(), joySticks.end(), nullptr);
+    if (!count)
+    {
+        OIS::InputManager::destroyInputSystem(ois);
+        return joySticks;
+    }
+
+    // Destroyed with its last joystick
+    std::lock_guard<std::mutex> lock(mJoyStickMutex);
+    mJoyStickCounts[ois] = count;
+    for (auto js : joySticks) if (js) mJoyStickSystems[js] = ois;
+    return joySticks;
+}
+
+
+void OISBackend::destroyJoyStick(OIS::JoyStick* joystick)
+{
+    std::lock_guard<std::mutex> lock(mJoyStickMutex);
+    auto it = mJoyStickSystems.find(joystick);
+    if (it == mJoyStickSystems.end()) return;
+
+    OIS::InputManager* ois = it->second;
+    ois->destroyInputObject(joystick);
+    mJoyStickSystems.erase(it);
+    if (--mJoyStickCounts[ois]) return;
+    mJoyStickCounts.erase(ois);
+    OIS::InputManager::destroyInputSystem(ois);
+}
@@ -0,0 +1,116 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace OIS
+{
+    class InputManager;
+    class JoyStick;
+    class Keyboard;
+    class Mouse;
+} // namespace OIS
+
+struct _XDisplay; // X11 'Display'
+
+
+namespace oism
+{
+
+
+//! Input system and the devices created with it
+struct DeviceSet
+{
+    DeviceSet() : ois(nullptr), mouse(nullptr), keyboard(nullptr), exclusive(false) {}
+
+    OIS::InputManager* ois; //!< Null if the backend doesn't use OIS
+    OIS::Mouse* mouse;
+    OIS::Keyboard* keyboard;
+    std::vector<OIS::JoyStick*> joySticks;
+    bool exclusive; //!< Mode the devices were created in
+};
+
+
+//! Create the devices of a handler.
+//! Devices report events to their listener when captured, like buffered OIS devices.
+//! Both functions don't touch the handler and can run on any thread.
+class DeviceBackend
+{
+public:
+    virtual ~DeviceBackend() {}
+
+    virtual DeviceSet create(unsigned long windowID, bool exclusive, bool verbose, bool joySticks) = 0;
+    virtual void destroy(DeviceSet& devices) = 0; //!< Reset 'devices'
+
+    /// Switch the exclusive mode of existing devices, on the dispatching thread.
+    /// Return false if it can't, the devices are then recreated.
+    virtual bool setExclusive(const DeviceSet& devices, unsigned long windowID, bool exclusive) { return false; }
+    /// Whether devices can be created and destroyed while others are captured
+    virtual bool isThreadSafe() const { return true; }
+
+    /// @name Joystick hotplug
+    /// Called by the scanner thread of 'Handler::enableJoyStickHotplug()'.
+    /// A joystick identity is its vendor, "#" and its ordinal among the connected
+    /// joysticks of that vendor, eg. "Logitech#1". Identical joysticks can't be
+    /// told apart: when the first of two is unplugged, the second one becomes
+    /// "Logitech#0" and get the number of the first.
+    ///@{
+    /// Identities of the connected joysticks, in enumeration order.
+    /// Return false if the backend can't enumerate them.
+    virtual bool listJoySticks(unsigned long windowID, std::vector<std::string>& identities) { return false; }
+    /// Joysticks of some listed identities, in the same order, null for those gone meanwhile
+    virtual std::vector<OIS::JoyStick*> createJoySticks(unsigned long windowID, const std::vector<std::string>& identities);
+    virtual void destroyJoyStick(OIS::JoyStick* joystick) {} //!< Created by 'createJoySticks()'
+
+    /// Identities of joysticks by vendor, in enumeration order
+    static std::vector<std::string> makeJoyStickIdentities(const std::vector<std::string>& vendors);
+    ///@}
+};
+
+
+//! Devices of an OIS input system bound to a window.
+//! On Linux, devices created non-exclusive are switched in place by grabbing the
+//! pointer and keyboard and hiding the cursor on a separate X11 connection. The
+//! pointer is confined but not recentered, relative motion stops at the window
+//! edges. Xlib connections can only be used across threads after 'XInitThreads()',
+//! which must be called before any other Xlib function, so devices aren't created
+//! in the background by default there.
+//! OIS enumerates joysticks when an input system is created, the hotplug scanner
+//! creates one when the connected joysticks may have changed, on Linux when the
+//! device nodes of '/dev/input' change, and each interval elsewhere.
+class OISBackend : public DeviceBackend
+{
+public:
+    OISBackend();
+    ~OISBackend();
+
+    DeviceSet create(unsigned long windowID, bool exclusive, bool verbose, bool joySticks);
+    void destroy(DeviceSet& devices);
+    bool setExclusive(const DeviceSet& devices, unsigned long windowID, bool exclusive);
+    bool isThreadSafe() const;
+
+    bool listJoySticks(unsigned long windowID, std::vector<std::string>& identities);
+    std::vector<OIS::JoyStick*> createJoySticks(unsigned long windowID, const std::vector<std::string>& identities);
+    void destroyJoyStick(OIS::JoyStick* joystick);
+
+private:
+    _XDisplay* mDisplay; //!< Grabbing in place, opened on first use
+    unsigned long mBlankCursor;
+
+    // Joystick hotplug
+    std::mutex mJoyStickMutex;
+    bool mJoyStickListed;
+    std::vector<std::string> mJoyStickNodes; //!< Device nodes of the last enumeration
+    std::vector<std::string> mJoyStickIdentities; //!< Of the last enumeration
+    std::unordered_map<OIS::JoyStick*, OIS::InputManager*> mJoyStickSystems; //!< Creator of each joystick
+    std::unordered_map<OIS::InputManager*, unsigned> mJoyStickCounts; //!< Joysticks of each input system
+};
+
+
+} // namespace oism
@@ -0,0 +1,85 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMFileWatcher.h"
+#include "OISMHandler.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#define OISM_USE_INOTIFY
+#endif
+
+
+using namespace oism;
+
+
+FileWatcher::FileWatcher(const std::vector<std::string>& files)
+:   mFd(-1)
+{
+#ifdef OISM_USE_INOTIFY
+    mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mFd < 0)
+    {
+        log::log(log::Level::Error, "FileWatcher: inotify_init1 failed");
+        return;
+    }
+
+    for (auto& file : files)
+    {
+        size_t slash = file.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : file.substr(0, slash + 1);
+        std::string name = slash == std::string::npos ? file : file.substr(slash + 1);
+
+        // Same directory return the same descriptor
+        int wd = inotify_add_watch(mFd, dir.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM);
+        if (wd < 0)
+        {
+            log::log(log::Level::Error, "FileWatcher: Can't watch directory: ", dir);
+            continue;
+        }
+        mFiles.push_back(std::make_pair(wd, name));
+    }
+#else
+    (void)files;
+    log::log(log::Level::Warning, "FileWatcher: Not supported on this platform");
+#endif
+}
+
+
+FileWatcher::~FileWatcher()
+{
+#ifdef OISM_USE_INOTIFY
+    if (mFd >= 0) close(mFd);
+#endif
+}
+
+
+bool FileWatcher::poll()
+{
+    bool changed = false;
+
+#ifdef OISM_USE_INOTIFY
+    if (mFd < 0) return false;
+
+    alignas(inotify_event) char buf[4096];
+    for (;;)
+    {
+        ssize_t size = read(mFd, buf, sizeof(buf));
+        if (size <= 0) break; // EAGAIN, nothing left
+
+        for (char* p = buf; p < buf + size; )
+        {
+            auto evt = reinterpret_cast<inotify_event*>(p);
+            p += sizeof(inotify_event) + evt->len;
+            if (!evt->len) continue;
+
+            for (auto& file : mFiles)
+                if (file.first == evt->wd && file.second == evt->name) changed = true;
+        }
+    }
+#endif
+
+    return changed;
+}
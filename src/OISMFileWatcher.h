@@ -0,0 +1,38 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace oism
+{
+
+
+//! Report changes to a set of files, polled without blocking.
+//! Parent directories are watched so files replaced by a rename are still seen.
+//! Implemented with Linux inotify, elsewhere nothing is ever reported.
+class FileWatcher
+{
+public:
+    FileWatcher(const std::vector<std::string>& files);
+    ~FileWatcher();
+
+    bool isOpen() const { return mFd >= 0; }
+
+    /// Return true if a file was written, replaced or deleted since the last call
+    bool poll();
+
+private:
+    FileWatcher(const FileWatcher&);
+    FileWatcher& operator=(const FileWatcher&);
+
+    int mFd;
+    std::vector<std::pair<int, std::string>> mFiles; //!< Directory watch descriptor, file name
+};
+
+
+} // namespace oism
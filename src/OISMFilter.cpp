@@ -0,0 +1,173 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+using namespace oism;
+
+
+namespace
+{
+
+// Stateful stages snap to their target when this close
+const float g_epsilon = 1e-4f;
+
+inline float with_sign(float magnitude, float x) { return x < 0.f ? -magnitude : magnitude; }
+
+} // namespace
+
+
+const unsigned FilterBank::None;
+
+
+void FilterBank::clear()
+{
+    mSlots.clear();
+    mIds.clear();
+    mInputs.clear();
+    mOutputs.clear();
+    mFirstStage.clear();
+    mActive.clear();
+    mActiveList.clear();
+    mChanged.clear();
+    mTypes.clear();
+    mA.clear();
+    mB.clear();
+    mState.clear();
+}
+
+
+void FilterBank::add(unsigned bind, const FilterChain& chain, float input)
+{
+    if (mFirstStage.empty()) mFirstStage.push_back(0);
+
+    unsigned slot = mIds.size();
+    if (bind >= mSlots.size()) mSlots.resize(bind + 1, None);
+    mSlots[bind] = slot;
+
+    mIds.push_back(bind);
+    mInputs.push_back(input);
+    mOutputs.push_back(0.f);
+    mActive.push_back(0);
+    for (auto& stage : chain)
+    {
+        mTypes.push_back(stage.type);
+        mA.push_back(stage.a);
+        mB.push_back(stage.type == FilterStage::FT_ACCEL && stage.b == 0.f ? 1.f : stage.b);
+        mState.push_back(0.f);
+    }
+    mFirstStage.push_back(mTypes.size());
+
+    // Outputs start from zero, stateful stages ramp up to the current input
+    _activate(slot);
+}
+
+
+void FilterBank::copyState(unsigned bind, const FilterBank& from)
+{
+    if (!isFiltered(bind) || !from.isFiltered(bind)) return;
+    unsigned slot = mSlots[bind], fromSlot = from.mSlots[bind];
+    unsigned first = mFirstStage[slot], fromFirst = from.mFirstStage[fromSlot];
+    unsigned count = mFirstStage[slot + 1] - first;
+    if (from.mFirstStage[fromSlot + 1] - fromFirst != count) return;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (mTypes[first + i] != from.mTypes[fromFirst + i] || mA[first + i] != from.mA[fromFirst + i] ||
+            mB[first + i] != from.mB[fromFirst + i]) return;
+    }
+
+    mOutputs[slot] = from.mOutputs[fromSlot];
+    std::copy(from.mState.begin() + fromFirst, from.mState.begin() + fromFirst + count, mState.begin() + first);
+}
+
+
+const std::vector<unsigned>& FilterBank::process()
+{
+    mChanged.clear();
+    for (unsigned i = 0; i < mActiveList.size();)
+    {
+        unsigned slot = mActiveList[i];
+        float output = _evaluate(slot);
+        if (output != mOutputs[slot])
+        {
+            mOutputs[slot] = output;
+            mChanged.push_back(slot);
+        }
+
+        if (!_isIdle(slot))
+        {
+            i++;
+            continue;
+        }
+        mActive[slot] = 0;
+        mActiveList[i] = mActiveList.back();
+        mActiveList.pop_back();
+    }
+    return mChanged;
+}
+
+
+float FilterBank::_evaluate(unsigned slot)
+{
+    float x = mInputs[slot];
+    for (unsigned s = mFirstStage[slot]; s < mFirstStage[slot + 1]; s++)
+    {
+        const float a = mA[s];
+        switch (mTypes[s])
+        {
+            case FilterStage::FT_SCALE:
+                x *= a;
+                break;
+
+            case FilterStage::FT_SMOOTH:
+            {
+                float y = x + a * (mState[s] - x);
+                mState[s] = x = std::fabs(y - x) < g_epsilon ? x : y;
+                break;
+            }
+
+            case FilterStage::FT_POWER:
+                x = with_sign(std::pow(std::fabs(x), a), x);
+                break;
+
+            case FilterStage::FT_BEZIER:
+            {
+                float t = std::fabs(x);
+                if (t >= 1.f) break;
+                float u = 1.f - t;
+                x = with_sign(3.f * u * u * t * a + 3.f * u * t * t * mB[s] + t * t * t, x);
+                break;
+            }
+
+            case FilterStage::FT_ACCEL:
+            {
+                float magnitude = std::fabs(x);
+                x *= 1.f + a * (mB[s] == 1.f ? magnitude : std::pow(magnitude, mB[s]));
+                break;
+            }
+
+            case FilterStage::FT_RAMP:
+            {
+                float delta = x - mState[s];
+                if (std::fabs(delta) > a) x = mState[s] + with_sign(a, delta);
+                mState[s] = x;
+                break;
+            }
+        }
+    }
+    return x;
+}
+
+
+bool FilterBank::_isIdle(unsigned slot) const
+{
+    if (mInputs[slot] != 0.f || mOutputs[slot] != 0.f) return false;
+    for (unsigned s = mFirstStage[slot]; s < mFirstStage[slot + 1]; s++)
+        if (mState[s] != 0.f) return false;
+    return true;
+}
@@ -0,0 +1,103 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <vector>
+
+
+namespace oism
+{
+
+
+//! Stage of a binding's analog filter chain, see 'Bind::addFilter()'
+struct FilterStage
+{
+    enum Type
+    {
+        FT_SCALE, //!< x * a, sensitivity of the binding
+        FT_SMOOTH, //!< Exponential smoothing, 'a' in [0, 1) is the weight of the previous output
+        FT_POWER, //!< sign(x) * |x|^a
+        FT_BEZIER, //!< Cubic curve from 0 to 1 with control points 'a' and 'b', applied to |x| below 1
+        FT_ACCEL, //!< x * (1 + a * |x|^b), 'b' is 1 by default
+        FT_RAMP, //!< Move toward x by at most 'a' per update, eg. keys driving an analog value
+        FT_COUNT
+    };
+
+    static FilterStage create(unsigned type, float a, float b = 0.f)
+    {
+        FilterStage s = {type, a, b};
+        return s;
+    }
+
+    bool operator==(const FilterStage& o) const { return type == o.type && a == o.a && b == o.b; }
+    bool operator!=(const FilterStage& o) const { return !(*this == o); }
+
+    unsigned type;
+    float a, b;
+};
+
+typedef std::vector<FilterStage> FilterChain;
+
+
+//! Filter chains of the bindings of a map, evaluated together once per update.
+//! Parameters and state of every stage are kept in contiguous arrays, only
+//! the chains whose input or state isn't zero are evaluated.
+class FilterBank
+{
+public:
+    static const unsigned None = ~0u;
+
+    void clear();
+    void add(unsigned bind, const FilterChain& chain, float input);
+    /// Keep the output and stage states of 'bind' in 'from' if its chain is the same
+    void copyState(unsigned bind, const FilterBank& from);
+    bool empty() const { return mIds.empty(); }
+    bool isFiltered(unsigned bind) const { return bind < mSlots.size() && mSlots[bind] != None; }
+
+    /// Return false if the binding isn't filtered
+    inline bool setInput(unsigned bind, float value)
+    {
+        if (bind >= mSlots.size() || mSlots[bind] == None) return false;
+        unsigned slot = mSlots[bind];
+        mInputs[slot] = value;
+        _activate(slot);
+        return true;
+    }
+    float getInput(unsigned bind) const { return mInputs[mSlots[bind]]; }
+
+    /// Evaluate the active chains, return the slots whose output changed
+    const std::vector<unsigned>& process();
+    unsigned getId(unsigned slot) const { return mIds[slot]; }
+    float getOutput(unsigned slot) const { return mOutputs[slot]; }
+
+private:
+    inline void _activate(unsigned slot)
+    {
+        if (mActive[slot]) return;
+        mActive[slot] = 1;
+        mActiveList.push_back(slot);
+    }
+    float _evaluate(unsigned slot); //!< Return the output, update the stage states
+    bool _isIdle(unsigned slot) const;
+
+    std::vector<unsigned> mSlots; //!< By binding ID
+
+    // By slot
+    std::vector<unsigned> mIds;
+    std::vector<float> mInputs;
+    std::vector<float> mOutputs;
+    std::vector<unsigned> mFirstStage; //!< One more for the end of the last chain
+    std::vector<unsigned char> mActive;
+    std::vector<unsigned> mActiveList;
+    std::vector<unsigned> mChanged;
+
+    // By stage
+    std::vector<unsigned char> mTypes;
+    std::vector<float> mA;
+    std::vector<float> mB;
+    std::vector<float> mState;
+};
+
+
+} // namespace oism
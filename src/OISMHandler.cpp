@@ -2,8 +2,11 @@
 // Copyright (C) 2012 Sebastien Raymond
 
 #include "OISMHandler.h"
+#include "OISMFileWatcher.h"
+#include "OISMInputThread.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <sstream>
 
@@ -11,8 +14,39 @@
 using namespace oism;
 
 
-// Globals
-log::Func_t oism::log::g_Func;
+/*
+=====================
+SymbolTable
+=====================
+*/
+
+
+bool SymbolTable::insert(unsigned hash, BindId id)
+{
+    if ((mCount + 1) * 2 > mSlots.size())
+    {
+        // Grow and rehash
+        std::vector<Slot> old;
+        old.swap(mSlots);
+        mSlots.assign(old.empty() ? 16 : old.size() * 2, {0, InvalidId});
+        mCount = 0;
+        for (auto& slot : old)
+            if (slot.id != InvalidId) insert(slot.hash, slot.id);
+    }
+
+    unsigned mask = mSlots.size() - 1;
+    for (unsigned i = hash & mask; ; i = (i + 1) & mask)
+    {
+        Slot& slot = mSlots[i];
+        if (slot.id == InvalidId)
+        {
+            slot = {hash, id};
+            ++mCount;
+            return true;
+        }
+        if (slot.hash == hash) return false;
+    }
+}
 
 
 /*
@@ -28,147 +62,445 @@ Bind* NamedBindingMap::getBinding(const std::string& name, bool forUse/* = true*
     auto it = map.find(name);
     if (it == map.end())
     {
-        log::log("New binding '"+name+"'");
-        if (forUse) log::log("No input assigned for binding: '"+name+"'", log::Level::Warning);
+        log::log(log::Level::Info, "New binding '", name, "'");
+        if (forUse) log::log(log::Level::Warning, "No input assigned for binding: '", name, "'");
         it = map.insert(std::make_pair(name, new Bind())).first;
+
+        Bind* b = it->second;
+        b->mId = list.size();
+        b->mValues = &values;
+        b->mRevision = &revision;
+        b->mHandler = handler;
+        list.push_back(b);
+        names.push_back(&it->first);
+        values.push_back(0.f);
+        if (changed.size() * 32 < values.size()) changed.push_back(0);
+        ++revision;
+
+        if (!symbols.insert(BindingName(name).hash, b->mId))
+        {
+#ifndef NDEBUG
+            log::log(log::Level::Error, "Binding name hash collision: '", name, "' and '",
+                *names[symbols.find(BindingName(name).hash)], "'");
+#endif
+        }
     }
     return it->second;
 }
 
 
+Bind* NamedBindingMap::getBinding(const BindingName& name, bool forUse/* = true*/)
+{
+    BindId id = symbols.find(name.hash);
+    if (id == SymbolTable::InvalidId) return getBinding(std::string(name.str), forUse);
+
+#ifndef NDEBUG
+    if (*names[id] != name.str)
+        log::log(log::Level::Error, "Binding name hash collision: '", name.str, "' resolved to '",
+            *names[id], "'");
+#endif
+    return list[id];
+}
+
+
+void NamedBindingMap::clear()
+{
+    // Bindings still referenced elsewhere now read zero
+    for (auto b : list)
+    {
+        b->mValues = nullptr;
+        b->mRevision = nullptr;
+        b->mHandler = nullptr;
+    }
+
+    map.clear();
+    symbols.clear();
+    names.clear();
+    list.clear();
+    values.clear();
+    changed.clear();
+    filters.clear();
+    ++revision;
+}
+
+
 /*
 =====================
-Bind
+CallbackHandle
+=====================
+*/
+
+
+CallbackHandle::CallbackHandle(CallbackHandle&& other)
+:   mRegistry(std::move(other.mRegistry)),
+    mIndex(other.mIndex),
+    mGeneration(other.mGeneration)
+{
+    other.mRegistry.reset();
+}
+
+
+CallbackHandle& CallbackHandle::operator=(CallbackHandle&& other)
+{
+    if (this != &other)
+    {
+        reset();
+        mRegistry = std::move(other.mRegistry);
+        mIndex = other.mIndex;
+        mGeneration = other.mGeneration;
+        other.mRegistry.reset();
+    }
+    return *this;
+}
+
+
+void CallbackHandle::reset()
+{
+    if (auto registry = mRegistry.lock()) registry->remove(mIndex, mGeneration);
+    mRegistry.reset();
+}
+
+
+bool CallbackHandle::isValid() const
+{
+    auto registry = mRegistry.lock();
+    return registry && registry->isValid(mIndex, mGeneration);
+}
+
+
+/*
+=====================
+CallbackRegistry
 =====================
 */
 
 
-void Bind::setValue(Handler* handler, float val)
+CallbackHandle CallbackRegistry::add(Bind* b, unsigned callbackType, const Callback& cb)
 {
-    if (mValue == val) return;
+    unsigned slot;
+    if (mFreeSlots.empty())
+    {
+        slot = mSlots.size();
+        mSlots.push_back({0, nullptr, 0});
+    }
+    else
+    {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+
+    b->mCallbackRegistry = this;
+    mSlots[slot].list = &b->mCallbacks[callbackType];
 
-    float oldVal = mValue;
-    mValue = val;
+    // Don't reallocate a list being iterated
+    if (mDispatchDepth) mPendingInsert.push_back(std::make_pair(slot, cb));
+    else _insert(slot, cb);
+
+    return CallbackHandle(shared_from_this(), slot, mSlots[slot].generation);
+}
+
+
+void CallbackRegistry::remove(unsigned index, unsigned generation)
+{
+    if (!isValid(index, generation)) return;
 
-    float high = _getMaxValue(handler);
-    if (fabs(high) > fabs(mValue)) mValue = high;
+    Slot& slot = mSlots[index];
+    ++slot.generation; // Invalidate handles now
 
-    if (oldVal == 0.f)
+    if (mDispatchDepth)
     {
-        if (mValue > 0.f) doCallback(CT_ON_POSITIVE);
-        if (mValue < 0.f) doCallback(CT_ON_NEGATIVE);
+        // Callback may be running, destroy it later
+        if (slot.dense < slot.list->size() && (*slot.list)[slot.dense].slot == index)
+            (*slot.list)[slot.dense].active = false;
+        mPendingErase.push_back(index);
+    }
+    else
+    {
+        _erase(index);
     }
-    else if (mValue == 0.f) doCallback(CT_ON_CENTER);
 }
 
 
-void Bind::doCallback(unsigned callbackType)
+void CallbackRegistry::dispatch(EntryList& list)
 {
-    CallbackWeakPtrList& ls = mCallbacks[callbackType];
-    
-    for (auto it = ls.begin(); it != ls.end(); )
+    ++mDispatchDepth;
+    for (unsigned i = 0; i < list.size(); i++)
     {
-        std::shared_ptr<Callback> cb = it->lock();
-        if (cb.get())
-        {
-            (*cb.get())();
-            ++it;
-        }
-        else
+        if (!list[i].active) continue;
+        counters::add(counters::CNT_CALLBACKS_FIRED);
+        list[i].func();
+    }
+    --mDispatchDepth;
+
+    if (!mDispatchDepth && (!mPendingErase.empty() || !mPendingInsert.empty()))
+        _processPending();
+}
+
+
+void CallbackRegistry::_insert(unsigned slot, const Callback& cb)
+{
+    EntryList& list = *mSlots[slot].list;
+    mSlots[slot].dense = list.size();
+    list.push_back({cb, slot, true});
+}
+
+
+void CallbackRegistry::_erase(unsigned slot)
+{
+    counters::add(counters::CNT_CALLBACKS_REMOVED);
+    Slot& s = mSlots[slot];
+    EntryList& list = *s.list;
+
+    // Callbacks are unordered, move the last one into the hole
+    if (s.dense != list.size() - 1)
+    {
+        list[s.dense] = std::move(list.back());
+        mSlots[list[s.dense].slot].dense = s.dense;
+    }
+    list.pop_back();
+
+    s.list = nullptr;
+    mFreeSlots.push_back(slot);
+}
+
+
+void CallbackRegistry::_processPending()
+{
+    // Insert first, a pending callback may also be pending removal
+    for (auto& pair : mPendingInsert) _insert(pair.first, pair.second);
+    mPendingInsert.clear();
+
+    for (auto slot : mPendingErase) _erase(slot);
+    mPendingErase.clear();
+}
+
+
+/*
+=====================
+Bind
+=====================
+*/
+
+
+bool Bind::setValue(unsigned source, float val)
+{
+    if (mSources[source] == val)
+    {
+        counters::add(counters::CNT_SET_VALUE_NOOPS);
+        return false;
+    }
+    float oldVal = _getMaxValue();
+    mSources[source] = val;
+
+    // Replay the matches from the leaf up to the root
+    unsigned size = mSources.size();
+    for (unsigned i = (size + source) >> 1; i; i >>= 1)
+    {
+        unsigned left = mMaxTree[i << 1];
+        unsigned right = mMaxTree[(i << 1) + 1];
+        mMaxTree[i] = std::fabs(mSources[right]) > std::fabs(mSources[left]) ? right : left;
+    }
+
+    return _getMaxValue() != oldVal;
+}
+
+
+void Bind::_resetSources(unsigned count)
+{
+    unsigned size = 1;
+    while (size < count) size <<= 1;
+
+    mSources.assign(size, 0.f);
+    mMaxTree.resize(size * 2);
+    for (unsigned i = 0; i < size; i++) mMaxTree[size + i] = i;
+    for (unsigned i = size - 1; i; i--) mMaxTree[i] = mMaxTree[i << 1];
+
+    mSourceCount = count;
+    mFreeSources.clear();
+    mSequenceSource = DispatchTable::InvalidSource;
+}
+
+
+unsigned Bind::_addSource()
+{
+    if (!mFreeSources.empty())
+    {
+        unsigned source = mFreeSources.back();
+        mFreeSources.pop_back();
+        return source;
+    }
+
+    unsigned size = mSources.size();
+    if (mSourceCount == size)
+    {
+        // Double the leaves and replay every match, current values are kept
+        mSources.resize(size * 2, 0.f);
+        size *= 2;
+        mMaxTree.resize(size * 2);
+        for (unsigned i = 0; i < size; i++) mMaxTree[size + i] = i;
+        for (unsigned i = size - 1; i; i--)
         {
-            it = ls.erase(it);
+            unsigned left = mMaxTree[i << 1];
+            unsigned right = mMaxTree[(i << 1) + 1];
+            mMaxTree[i] = std::fabs(mSources[right]) > std::fabs(mSources[left]) ? right : left;
         }
     }
+    return mSourceCount++;
+}
+
+
+void Bind::_removeSource(unsigned source)
+{
+    setValue(source, 0.f);
+    mFreeSources.push_back(source);
+}
+
+
+void Bind::doCallback(unsigned callbackType)
+{
+    if (mCallbackRegistry) mCallbackRegistry->dispatch(mCallbacks[callbackType]);
+}
+
+
+void Bind::addFilter(const FilterStage& stage)
+{
+    mFilters.push_back(stage);
+    if (mRevision) ++*mRevision;
+}
+
+
+void Bind::clearFilters()
+{
+    if (mFilters.empty()) return;
+    mFilters.clear();
+    if (mRevision) ++*mRevision;
+}
+
+
+void Bind::addSequence(const BindSequence& sequence)
+{
+    mSequences.push_back(sequence);
+    if (mRevision) ++*mRevision;
 }
 
 
-const Bind::CallbackSharedPtr& Bind::addCallback(unsigned callbackType, const CallbackSharedPtr& cb)
+void Bind::clearSequences()
 {
-    mCallbacks[callbackType].push_back(CallbackWeakPtr(cb));
-    return cb;
+    if (mSequences.empty()) return;
+    mSequences.clear();
+    if (mRevision) ++*mRevision;
 }
 
 
 void Bind::addKeyEvent(InputEvent::Type evt)
 {
     mKeyEvents.push_back(evt);
+    if (mRevision) ++*mRevision;
+    if (mHandler) mHandler->_editDispatch(this, mHandler->mKeyEvents, KeyEvent::getSlot(evt), evt, true);
 }
 
 
 void Bind::addMouseEvent(InputEvent::Type evt)
 {
     mMouseEvents.push_back(evt);
+    if (mRevision) ++*mRevision;
+    if (mHandler) mHandler->_editDispatch(this, mHandler->mMouseEvents, MouseEvent::getSlot(evt), evt, true);
 }
 
 
 void Bind::addJoyStickEvent(InputEvent::Type evt)
 {
     mJoyStickEvents.push_back(evt);
+    if (mRevision) ++*mRevision;
+    if (mHandler) mHandler->_editDispatch(this, mHandler->mJoyStickEvents, JoyStickEvent::getSlot(evt), evt, true);
 }
 
 
 void Bind::removeKeyEvent(InputEvent::Type evt)
 {
     auto it = std::find(mKeyEvents.begin(), mKeyEvents.end(), evt);
-    if (it != mKeyEvents.end()) mKeyEvents.erase(it);
+    if (it == mKeyEvents.end()) return;
+    mKeyEvents.erase(it);
+    if (mRevision) ++*mRevision;
+    if (mHandler) mHandler->_editDispatch(this, mHandler->mKeyEvents, KeyEvent::getSlot(evt), evt, false);
 }
 
 
 void Bind::removeMouseEvent(InputEvent::Type evt)
 {
     auto it = std::find(mMouseEvents.begin(), mMouseEvents.end(), evt);
-    if (it != mMouseEvents.end()) mMouseEvents.erase(it);
+    if (it == mMouseEvents.end()) return;
+    mMouseEvents.erase(it);
+    if (mRevision) ++*mRevision;
+    if (mHandler) mHandler->_editDispatch(this, mHandler->mMouseEvents, MouseEvent::getSlot(evt), evt, false);
 }
 
 
 void Bind::removeJoyStickEvent(InputEvent::Type evt)
 {
     auto it = std::find(mJoyStickEvents.begin(), mJoyStickEvents.end(), evt);
-    if (it != mJoyStickEvents.end()) mJoyStickEvents.erase(it);
+    if (it == mJoyStickEvents.end()) return;
+    mJoyStickEvents.erase(it);
+    if (mRevision) ++*mRevision;
+    if (mHandler) mHandler->_editDispatch(this, mHandler->mJoyStickEvents, JoyStickEvent::getSlot(evt), evt, false);
 }
 
 
-float Bind::_getMaxValue(Handler* handler) const
+/*
+=====================
+DispatchTable
+=====================
+*/
+
+
+void DispatchTable::reset(unsigned slotCount)
 {
-    float high = 0.f;
-    auto kb = handler->getKeyboard();
-    auto mouse = handler->getMouse();
+    mSlots.clear();
+    mSlots.resize(slotCount);
+    mBitmap.assign((slotCount + 31) / 32, 0);
+}
+
 
-    // Key on/off
-    for (auto evt : mKeyEvents)
+void DispatchTable::add(InputEvent::Type evt, unsigned slot, Bind* b, unsigned source)
+{
+    if (slot >= mSlots.size())
     {
-        if (kb->isKeyDown((OIS::KeyCode)KeyEvent::getKey(evt)))
-        {
-            if (KeyEvent::getReverse(evt)) high = -1.f;
-            else high = 1.f;
-        }
+        mSlots.resize(slot + 1);
+        mBitmap.resize(slot / 32 + 1, 0);
     }
 
-    for (auto& evt : mMouseEvents)
-    {
-        unsigned component = MouseEvent::getComponent(evt);
-        if (component < MouseEvent::CPNT_BUTTON_COUNT)
-        {
-            // Mouse button on/off
-            if (mouse->getMouseState().buttonDown((OIS::MouseButtonID)component))
-            {
-                if (MouseEvent::getReverse(evt)) high = -1.f;
-                else high = 1.f;
-            }
-        }
-        else
-        {
-            // Mouse axis
+    mSlots[slot].push_back({b, source, InputEvent::getReverse(evt) ? -1.f : 1.f});
+    mBitmap[slot >> 5] |= 1u << (slot & 31);
+}
 
-        }
-    }
 
-    // Joystick
-    for (auto& evt : mJoyStickEvents)
-        if (float tmp = handler->getJoyStickValue(evt))
-           if (std::fabs(tmp) > std::fabs(high)) high = tmp;
+void DispatchTable::remove(unsigned slot, Bind* b)
+{
+    if (slot >= mSlots.size()) return;
+
+    EntryList& entries = mSlots[slot];
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [b](const Entry& e){return e.bind == b;}), entries.end());
+    if (entries.empty()) mBitmap[slot >> 5] &= ~(1u << (slot & 31));
+}
+
 
-    return high;
+unsigned DispatchTable::remove(InputEvent::Type evt, unsigned slot, Bind* b)
+{
+    if (slot >= mSlots.size()) return InvalidSource;
+
+    float sign = InputEvent::getReverse(evt) ? -1.f : 1.f;
+    EntryList& entries = mSlots[slot];
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->bind != b || it->sign != sign) continue;
+
+        unsigned source = it->source;
+        entries.erase(it);
+        if (entries.empty()) mBitmap[slot >> 5] &= ~(1u << (slot & 31));
+        return source;
+    }
+    return InvalidSource;
 }
 
 
@@ -201,13 +533,33 @@ bool JoyStickListener::buttonReleased(const OIS::JoyStickEvent& evt, int button)
 
 bool JoyStickListener::axisMoved(const OIS::JoyStickEvent& evt, int axis)
 {
-    mHandler->axisMoved(axis,
-        JoyStickEvent::normalizeAxisValue(evt.state.mAxes[axis].abs), this);
+    int value = evt.state.mAxes[axis].abs;
+    if (!mHandler->mConfig.joystickBatchAxes && _filterAxis(axis, value)) mHandler->axisMoved(axis, value, this);
     for (auto lnr : mListeners) lnr->axisMoved(evt, axis);
     return true;
 }
 
 
+bool JoyStickListener::_filterAxis(unsigned axis, int& value)
+{
+    const Handler::Configuration::AxisFilter& filter = mHandler->mConfig.getAxisFilter(mId, axis);
+    const int max = OIS::JoyStick::MAX_AXIS;
+
+    int deadZone = (int)(filter.deadZone * max);
+    int magnitude = std::min(std::abs(value), max);
+    if (magnitude <= deadZone) magnitude = 0;
+    else if (deadZone > 0) magnitude = (int)((long long)(magnitude - deadZone) * max / (max - deadZone));
+    value = value < 0 ? -magnitude : magnitude;
+
+    if (axis >= mLastAxes.size()) mLastAxes.resize(axis + 1, 0);
+    int& last = mLastAxes[axis];
+    if (value == last) return false;
+    if (magnitude != 0 && magnitude != max && std::abs(value - last) < filter.threshold * max) return false;
+    last = value;
+    return true;
+}
+
+
 bool JoyStickListener::povMoved(const OIS::JoyStickEvent& evt, int idx)
 {
     mHandler->povMoved(idx, evt.state.mPOV[idx].direction, this);
@@ -223,227 +575,934 @@ Handler
 */
 
 
-Handler::Handler(unsigned long windowID, bool exclusive/* = true*/)
-:   mOIS(nullptr), mMouse(nullptr), mKeyboard(nullptr),
-    mWindowID(windowID), mIsExclusive(exclusive),
-    mMouseRelativeUpdatedX(false),
-    mMouseRelativeUpdatedY(false),
-    mMouseRelativeUpdatedZ(false)
+Handler::Handler(unsigned long windowID, bool exclusive/* = true*/)
+:   mCallbackRegistry(std::make_shared<CallbackRegistry>()),
+    mBackend(std::make_shared<OISBackend>()),
+    mOIS(nullptr), mMouse(nullptr), mKeyboard(nullptr),
+    mFilterRevision(~0u), mFilterSmoothing(0.f), mSequenceRevision(~0u),
+    mEventTime(0), mEventTimeSet(false),
+    mSavedBindingRevision(0),
+    mWindowID(windowID), mIsExclusive(exclusive),
+    mAsyncDeviceCreation(mBackend->isThreadSafe()),
+    mDevicesExclusive(exclusive), mCreatedExclusive(exclusive), mCreatingExclusive(exclusive), mRequestedExclusive(exclusive),
+    mExclusivePending(false),
+    mBatchDepth(0),
+    mReloadPending(false),
+    mMouseRelativeUpdatedX(false),
+    mMouseRelativeUpdatedY(false),
+    mMouseRelativeUpdatedZ(false),
+    mMouseLastRelativeX(0.f),
+    mMouseLastRelativeY(0.f),
+    mMouseLastRelativeZ(0.f),
+    mMouseAccumX(0.f),
+    mMouseAccumY(0.f),
+    mMouseAccumZ(0.f),
+    mMouseAccumulated(false)
+{
+    mBindings.handler = this;
+    createOIS(exclusive);
+}
+
+
+Handler::Handler(const std::shared_ptr<DeviceBackend>& backend, unsigned long windowID/* = 0*/, bool exclusive/* = true*/)
+:   mCallbackRegistry(std::make_shared<CallbackRegistry>()),
+    mBackend(backend),
+    mOIS(nullptr), mMouse(nullptr), mKeyboard(nullptr),
+    mFilterRevision(~0u), mFilterSmoothing(0.f), mSequenceRevision(~0u),
+    mEventTime(0), mEventTimeSet(false),
+    mSavedBindingRevision(0),
+    mWindowID(windowID), mIsExclusive(exclusive),
+    mAsyncDeviceCreation(mBackend->isThreadSafe()),
+    mDevicesExclusive(exclusive), mCreatedExclusive(exclusive), mCreatingExclusive(exclusive), mRequestedExclusive(exclusive),
+    mExclusivePending(false),
+    mBatchDepth(0),
+    mReloadPending(false),
+    mMouseRelativeUpdatedX(false),
+    mMouseRelativeUpdatedY(false),
+    mMouseRelativeUpdatedZ(false),
+    mMouseLastRelativeX(0.f),
+    mMouseLastRelativeY(0.f),
+    mMouseLastRelativeZ(0.f),
+    mMouseAccumX(0.f),
+    mMouseAccumY(0.f),
+    mMouseAccumZ(0.f),
+    mMouseAccumulated(false)
+{
+    mBindings.handler = this;
+    createOIS(exclusive);
+}
+
+
+Handler::Handler()
+:   mCallbackRegistry(std::make_shared<CallbackRegistry>()),
+    mOIS(nullptr), mMouse(nullptr), mKeyboard(nullptr),
+    mFilterRevision(~0u), mFilterSmoothing(0.f), mSequenceRevision(~0u),
+    mEventTime(0), mEventTimeSet(false),
+    mSavedBindingRevision(0),
+    mWindowID(0), mIsExclusive(false),
+    mAsyncDeviceCreation(true),
+    mDevicesExclusive(false), mCreatedExclusive(false), mCreatingExclusive(false), mRequestedExclusive(false),
+    mExclusivePending(false),
+    mBatchDepth(0),
+    mReloadPending(false),
+    mMouseRelativeUpdatedX(false),
+    mMouseRelativeUpdatedY(false),
+    mMouseRelativeUpdatedZ(false),
+    mMouseLastRelativeX(0.f),
+    mMouseLastRelativeY(0.f),
+    mMouseLastRelativeZ(0.f),
+    mMouseAccumX(0.f),
+    mMouseAccumY(0.f),
+    mMouseAccumZ(0.f),
+    mMouseAccumulated(false)
+{
+    mBindings.handler = this;
+}
+
+
+Handler::~Handler()
+{
+    unwatch();
+    stopThread();
+
+    if (mPendingDevices.valid())
+    {
+        DeviceSet devices = mPendingDevices.get();
+        mBackend->destroy(devices);
+    }
+    if (mRetiredDevices.valid()) mRetiredDevices.wait();
+
+    if (mHotplug)
+    {
+        for (auto& pair : mJoySticks)
+        {
+            if (pair.first) mHotplug->retire(pair.first);
+            pair.first = nullptr;
+        }
+        mHotplug.reset();
+    }
+
+    if (mBackend) destroyOIS();
+}
+
+
+void Handler::update()
+{
+    mBindings.clearChanged();
+    if (mWatcher) _pollReload();
+    if (mBindings.revision != mSequenceRevision) _compileSequences();
+
+    if (!mThread)
+    {
+        captureDevices();
+        processInternalCallback();
+        _updateFilters();
+        return;
+    }
+
+    // Threaded mode, publish values and run callbacks on this thread
+    if (auto snapshot = mThread->acquireValues())
+    {
+        const std::vector<float>& values = snapshot->values;
+        unsigned size = std::min(values.size(), mBindings.values.size());
+        for (unsigned i = 0; i < size; i++)
+        {
+            if (mBindings.getInput(i) == values[i]) continue;
+            mBindings.setValue(i, values[i]);
+#ifdef OISM_ENABLE_LATENCY
+            if (i < snapshot->stamps.size() && snapshot->stamps[i].time)
+                _recordLatency(mBindings.list[i], LT_VALUE, snapshot->stamps[i]);
+#endif
+        }
+    }
+
+    InputThread::CallbackEvent evt;
+    while (mThread->popCallback(evt))
+    {
+        if (evt.bind >= mBindings.list.size()) continue;
+        Bind* b = mBindings.list[evt.bind];
+#ifdef OISM_ENABLE_LATENCY
+        if (evt.stamp.time && !b->mCallbacks[evt.type].empty()) _recordLatency(b, LT_CALLBACK, evt.stamp);
+#endif
+        b->doCallback(evt.type);
+    }
+
+    _updateFilters();
+}
+
+
+void Handler::_updateFilters()
+{
+    if (mBindings.revision != mFilterRevision || mConfig.mouseSmoothing != mFilterSmoothing) _buildFilters();
+    if (mBindings.filters.empty()) return;
+
+    FilterBank& filters = mBindings.filters;
+    for (auto slot : filters.process()) mBindings.setOutput(filters.getId(slot), filters.getOutput(slot));
+}
+
+
+void Handler::_buildFilters()
+{
+    mFilterRevision = mBindings.revision;
+    mFilterSmoothing = mConfig.mouseSmoothing;
+
+    FilterBank old;
+    std::swap(old, mBindings.filters);
+
+    FilterChain chain;
+    for (auto b : mBindings.list)
+    {
+        float input = old.isFiltered(b->mId) ? old.getInput(b->mId) : mBindings.values[b->mId];
+        chain = b->mFilters;
+
+        if (mFilterSmoothing > 0.f &&
+            std::none_of(chain.begin(), chain.end(),
+                [](const FilterStage& s){return s.type == FilterStage::FT_SMOOTH;}) &&
+            std::any_of(b->mMouseEvents.begin(), b->mMouseEvents.end(),
+                [](InputEvent::Type evt){return MouseEvent::getComponent(evt) > MouseEvent::CPNT_BUTTON_COUNT;}))
+        {
+            chain.insert(chain.begin(), FilterStage::create(FilterStage::FT_SMOOTH, mFilterSmoothing));
+        }
+
+        // No longer filtered, publish the raw value
+        if (chain.empty())
+        {
+            if (old.isFiltered(b->mId)) mBindings.setOutput(b->mId, input);
+            continue;
+        }
+        mBindings.filters.add(b->mId, chain, input);
+        if (old.isFiltered(b->mId)) mBindings.filters.copyState(b->mId, old); // Unchanged chains carry on
+        else mBindings.setOutput(b->mId, 0.f);
+    }
+}
+
+
+void Handler::captureDevices()
+{
+    _pollDevices();
+
+    mEventTime = recorder_now();
+    mEventTimeSet = true;
+    if (mRecorder) mRecorder->setTime(mEventTime);
+
+    if (mMouse)
+    {
+        clearMouseValue();
+        mMouse->capture();
+        _flushMouseRelative();
+    }
+    if (mKeyboard) mKeyboard->capture();
+
+    if (mHotplug) _pollJoySticks();
+    for (auto& pair : mJoySticks) if (pair.first) pair.first->capture();
+    if (mConfig.joystickBatchAxes) _dispatchJoyStickAxes();
+
+    if (mRecorder) mRecorder->frame(mMouse);
+    mEventTimeSet = false;
+}
+
+
+void Handler::startThread(unsigned rate/* = 1000*/, const Pump& pump/* = Pump()*/)
+{
+    if (mThread) return;
+
+    std::vector<float> values;
+    for (auto b : mBindings.list) values.push_back(b->_getMaxValue());
+
+    log::log(log::Level::Info, "Starting input thread: ", rate, "Hz");
+    mThread.reset(new InputThread(this, rate, pump ? pump : [this](){captureDevices();}, values));
+    mThread->start(); // Dispatch check 'mThread', start once it is set
+}
+
+
+void Handler::stopThread()
+{
+    if (!mThread) return;
+
+    log::log(log::Level::Info, "Stopping input thread");
+    mThread->stop();
+    update(); // Last values and callbacks
+    mThread.reset();
+}
+
+
+bool Handler::startRecording(const std::string& path, unsigned capacity/* = 65536*/)
+{
+    std::shared_ptr<Recorder> recorder(new Recorder(path, capacity));
+    if (!recorder->isOpen()) return false;
+
+    log::log(log::Level::Info, "Recording input to '", path, "'");
+    std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+    mInternalCallbacks.push([this,recorder](){mRecorder = recorder;});
+    return true;
+}
+
+
+void Handler::stopRecording()
+{
+    // Flushed by the recorder destructor
+    std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+    mInternalCallbacks.push([this](){mRecorder.reset();});
+}
+
+
+void Handler::setExclusive(bool exclusive/* = true*/)
+{
+    mExclusivePending = true;
+    {
+        std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+        mInternalCallbacks.push([this,exclusive](){_setExclusive(exclusive);});
+    }
+    mIsExclusive = exclusive; // Satisfy calls to getExclusive() before the callback is executed
+}
+
+
+// Internal callback
+void Handler::_setExclusive(bool exclusive)
+{
+    mRequestedExclusive = exclusive;
+
+    if (!mBackend) // No input system
+    {
+        mExclusivePending = false;
+        return;
+    }
+
+    // Restarted with the latest mode once done
+    if (mPendingDevices.valid()) return;
+
+    if (exclusive == mDevicesExclusive)
+    {
+        mExclusivePending = false;
+        return;
+    }
+
+    if (mExclusiveToggle ? mExclusiveToggle(exclusive) : mBackend->setExclusive(_getDevices(), mWindowID, exclusive))
+    {
+        log::log(log::Level::Info, "Switched exclusive mode in place: ", exclusive);
+        mDevicesExclusive = exclusive;
+        mExclusivePending = false;
+        return;
+    }
+
+    if (mAsyncDeviceCreation)
+    {
+        _createDevicesAsync(exclusive);
+        return;
+    }
+
+    _swapDevices(mBackend->create(mWindowID, exclusive, false, !mHotplug), exclusive);
+    mExclusivePending = false;
+}
+
+
+void Handler::_createDevicesAsync(bool exclusive)
+{
+    log::log(log::Level::Info, "Creating devices in background, exclusive mode: ", exclusive);
+    mCreatingExclusive = exclusive;
+    unsigned long windowID = mWindowID;
+    bool joySticks = !mHotplug;
+    std::shared_ptr<DeviceBackend> backend = mBackend;
+    mPendingDevices = std::async(std::launch::async, [backend, windowID, exclusive, joySticks]()
+    {
+        return backend->create(windowID, exclusive, false, joySticks);
+    });
+}
+
+
+void Handler::_pollDevices()
+{
+    if (!mPendingDevices.valid() ||
+        mPendingDevices.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+    _swapDevices(mPendingDevices.get(), mCreatingExclusive);
+    _setExclusive(mRequestedExclusive); // Requested meanwhile
+}
+
+
+DeviceSet Handler::_getDevices() const
+{
+    DeviceSet devices;
+    devices.ois = mOIS;
+    devices.mouse = mMouse;
+    devices.keyboard = mKeyboard;
+    devices.exclusive = mCreatedExclusive;
+    devices.joySticks = mStaleJoySticks;
+    if (!mHotplug) for (auto& pair : mJoySticks) if (pair.first) devices.joySticks.push_back(pair.first);
+    return devices;
+}
+
+
+void Handler::_swapDevices(const DeviceSet& devices, bool exclusive)
+{
+    DeviceSet old = _getDevices();
+
+    // Copy mouse limit
+    int mlw = 0; int mlh = 0;
+    if (mMouse)
+    {
+        mlw = mMouse->getMouseState().width;
+        mlh = mMouse->getMouseState().height;
+    }
+
+    // Joystick listeners are kept by joystick number
+    attachDevices(devices);
+    mStaleJoySticks.clear();
+    mDevicesExclusive = exclusive;
+    log::log(log::Level::Info, "Switched exclusive mode: ", exclusive);
+
+    // Restore mouse limit
+    if (old.mouse && mMouse) setMouseLimit(mlw,mlh);
+
+    if (!mAsyncDeviceCreation)
+    {
+        mBackend->destroy(old);
+        return;
+    }
+    // Waits for the previous destruction, if any
+    std::shared_ptr<DeviceBackend> backend = mBackend;
+    mRetiredDevices = std::async(std::launch::async, [backend, old]() mutable {backend->destroy(old);});
+}
+
+
+void Handler::processInternalCallback()
+{
+    std::queue<std::function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+        if (mInternalCallbacks.empty()) return;
+        std::swap(callbacks, mInternalCallbacks);
+    }
+
+    while (!callbacks.empty())
+    {
+        callbacks.front()();
+        callbacks.pop();
+    }
+}
+
+
+void Handler::createOIS(bool exclusive/* = true*/)
+{
+    mIsExclusive = mDevicesExclusive = mRequestedExclusive = exclusive;
+    attachDevices(mBackend->create(mWindowID, exclusive, true, true));
+}
+
+
+void Handler::destroyOIS()
+{
+    DeviceSet devices = _getDevices();
+    for (auto& pair : mJoySticks) delete pair.second; // JoyStickListener
+    mJoySticks.clear();
+    mStaleJoySticks.clear();
+    mMouse = nullptr;
+    mKeyboard = nullptr;
+    mOIS = nullptr;
+
+    mBackend->destroy(devices);
+}
+
+
+void Handler::attachDevices(const DeviceSet& devices)
+{
+    mOIS = devices.ois;
+    mMouse = devices.mouse;
+    mKeyboard = devices.keyboard;
+    mCreatedExclusive = devices.exclusive;
+    if (mMouse) mMouse->setEventCallback(this);
+    if (mKeyboard) mKeyboard->setEventCallback(this);
+    if (mHotplug) return;
+
+    // Listeners are kept for joystick numbers still present
+    for (unsigned i = devices.joySticks.size(); i < mJoySticks.size(); i++) delete mJoySticks[i].second;
+    mJoySticks.resize(devices.joySticks.size(), std::make_pair(nullptr, nullptr));
+
+    for (unsigned i = 0; i < mJoySticks.size(); i++)
+    {
+        auto& pair = mJoySticks[i];
+        if (!pair.second) pair.second = new JoyStickListener(this, i);
+        pair.first = devices.joySticks[i];
+        pair.first->setEventCallback(pair.second);
+    }
+}
+
+
+void Handler::enableJoyStickHotplug(unsigned interval/* = 1000*/)
+{
+    std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+    mInternalCallbacks.push([this,interval](){_enableJoyStickHotplug(interval);});
+}
+
+
+// Internal callback
+void Handler::_enableJoyStickHotplug(unsigned interval)
+{
+    if (mHotplug) return;
+    std::vector<std::string> identities;
+    if (!mBackend || !mBackend->listJoySticks(mWindowID, identities))
+    {
+        log::log(log::Level::Warning, "Joystick hotplug not supported by the device backend");
+        return;
+    }
+
+    // Keep current numbers, created in enumeration order
+    for (unsigned i = 0; i < identities.size() && i < mJoySticks.size(); i++)
+        mJoyStickNumbers[identities[i]] = i;
+
+    // Joysticks are back after the first scan, those created with the devices
+    // are destroyed with them
+    for (unsigned i = 0; i < mJoySticks.size(); i++)
+    {
+        if (!mJoySticks[i].first) continue;
+        mJoySticks[i].first->setEventCallback(nullptr);
+        mStaleJoySticks.push_back(mJoySticks[i].first);
+        mJoySticks[i].first = nullptr;
+        _releaseJoyStick(i);
+    }
+
+    log::log(log::Level::Info, "Joystick hotplug enabled");
+    mHotplug.reset(new JoyStickHotplug(mBackend, mWindowID, interval));
+    mHotplug->start();
+}
+
+
+void Handler::_pollJoySticks()
+{
+    // Changes are applied in order, other joysticks and their held inputs are kept
+    while (JoyStickHotplug::Scan* scan = mHotplug->pop())
+    {
+        for (auto& identity : scan->removed)
+        {
+            auto it = mJoyStickNumbers.find(identity);
+            if (it == mJoyStickNumbers.end() || !mJoySticks[it->second].first) continue;
+
+            unsigned num = it->second;
+            log::log(log::Level::Info, "Joystick ", num, " disconnected: ", identity);
+            mHotplug->retire(mJoySticks[num].first);
+            mJoySticks[num].first = nullptr;
+            _releaseJoyStick(num);
+        }
+
+        for (auto& dev : scan->added)
+        {
+            unsigned num = _getJoyStickNumber(dev.identity);
+            if (num >= mJoySticks.size()) mJoySticks.resize(num + 1, std::make_pair(nullptr, nullptr));
+
+            // Listeners stay, they belong to the joystick number
+            auto& pair = mJoySticks[num];
+            if (!pair.second) pair.second = new JoyStickListener(this, num);
+            log::log(log::Level::Info, "Joystick ", num, " connected: ", dev.identity);
+            pair.first = dev.joystick;
+            pair.first->setEventCallback(pair.second);
+        }
+        delete scan;
+    }
+}
+
+
+unsigned Handler::_getJoyStickNumber(const std::string& identity)
+{
+    auto it = mJoyStickNumbers.find(identity);
+    if (it != mJoyStickNumbers.end()) return it->second;
+
+    // Lowest number never used by another joystick, then lowest disconnected
+    std::vector<bool> reserved;
+    for (auto& pair : mJoyStickNumbers)
+    {
+        if (pair.second >= reserved.size()) reserved.resize(pair.second + 1, false);
+        reserved[pair.second] = true;
+    }
+
+    unsigned num = 0;
+    while (num < reserved.size() && reserved[num]) num++;
+    if (num == reserved.size())
+    {
+        for (unsigned i = 0; i < mJoySticks.size(); i++)
+        {
+            if (mJoySticks[i].first) continue;
+            num = i;
+            break;
+        }
+    }
+
+    // Forget the previous owner of the number
+    for (auto it = mJoyStickNumbers.begin(); it != mJoyStickNumbers.end(); )
+    {
+        if (it->second == num) it = mJoyStickNumbers.erase(it);
+        else ++it;
+    }
+
+    mJoyStickNumbers[identity] = num;
+    return num;
+}
+
+
+void Handler::_layoutAxisBatch()
+{
+    mAxisBatch.clear();
+    mAxisBatchJoySticks.clear();
+    for (unsigned i = 0; i < mJoySticks.size(); i++)
+    {
+        OIS::JoyStick* js = mJoySticks[i].first;
+        mAxisBatchJoySticks.push_back(js);
+        if (!js) continue;
+
+        for (unsigned axis = 0; axis < js->getJoyStickState().mAxes.size(); axis++)
+        {
+            const Configuration::AxisFilter& filter = mConfig.getAxisFilter(i, axis);
+            mAxisBatch.addLane(i, axis, filter.deadZone, filter.threshold);
+        }
+    }
+    mAxisBatchFilter = mConfig.joystickAxisFilter;
+    mAxisBatchFilters = mConfig.joystickAxisFilters;
+
+    // Lanes start at zero, so do their bound axes; buttons and POVs are kept
+    for (unsigned i = 0; i < mAxisBatch.size(); i++)
+    {
+        const AxisBatch::Lane& lane = mAxisBatch.getLane(i);
+        setBindingValue(mJoyStickEvents,
+            JoyStickEvent::getSlot(JoyStickEvent::create(OIS::OIS_Axis, lane.axis, lane.joystick)), 0.f);
+    }
+    for (auto& pair : mJoySticks) if (pair.first) pair.second->_resetAxes();
+}
+
+
+void Handler::_dispatchJoyStickAxes()
 {
-    createOIS(exclusive);
+    bool layout = mAxisBatchJoySticks.size() != mJoySticks.size() ||
+        !(mAxisBatchFilter == mConfig.joystickAxisFilter) || mAxisBatchFilters != mConfig.joystickAxisFilters;
+    for (unsigned i = 0; !layout && i < mJoySticks.size(); i++) layout = mAxisBatchJoySticks[i] != mJoySticks[i].first;
+    if (layout) _layoutAxisBatch();
+
+    for (unsigned i = 0; i < mAxisBatch.size(); i++)
+    {
+        const AxisBatch::Lane& lane = mAxisBatch.getLane(i);
+        mAxisBatch.setRaw(i, mJoySticks[lane.joystick].first->getJoyStickState().mAxes[lane.axis].abs);
+    }
+
+    if (!mAxisBatch.process()) return;
+    for (auto i : mAxisBatch.getChanged())
+    {
+        const AxisBatch::Lane& lane = mAxisBatch.getLane(i);
+        int value = (int)std::lround(mAxisBatch.getValue(i) * OIS::JoyStick::MAX_AXIS);
+        axisMoved(lane.axis, value, mJoySticks[lane.joystick].second);
+    }
 }
 
 
-Handler::~Handler()
+void Handler::_releaseJoyStick(unsigned joystick)
 {
-    destroyOIS();
+    unsigned first = joystick * JoyStickEvent::SlotCountPerJoyStick;
+    for (unsigned slot = first; slot < first + JoyStickEvent::SlotCountPerJoyStick; slot++)
+        setBindingValue(mJoyStickEvents, slot, 0.f);
+    if (joystick < mJoySticks.size() && mJoySticks[joystick].second) mJoySticks[joystick].second->_resetAxes();
 }
 
 
-void Handler::update()
+void Handler::setMouseLimit(int w, int h)
 {
     if (mMouse)
     {
-        clearMouseValue();
-        mMouse->capture();
+        log::log(log::Level::Info, "Setting mouse limit: width=", w, " height=", h); 
+        mMouse->getMouseState().width = w;
+        mMouse->getMouseState().height = h;
     }
-    if (mKeyboard) mKeyboard->capture();
-    for (auto& pair : mJoySticks) pair.first->capture();
-
-    processInternalCallback();
 }
 
 
-void Handler::setExclusive(bool exclusive/* = true*/)
+void Handler::_loadBinding(Serializer& s)
 {
-    mInternalCallbacks.push([this,exclusive](){_setExclusive(exclusive);});
-    mIsExclusive = exclusive; // Satisfy calls to getExclusive() before the callback is executed
+    // Keep the bindings already handed out
+    NamedBindingMap loaded;
+    s.loadBinding(loaded);
+    _mergeBindings(loaded, nullptr);
+    mSavedBindingPath = s.getPath();
+    mSavedBindingRevision = mBindings.revision;
 }
 
 
-// Internal callback
-void Handler::_setExclusive(bool exclusive)
+void Handler::_saveBinding(Serializer& s, bool onlyIfChanged/* = false*/)
 {
-    // Copy joystick listeners with device ID
-    std::unordered_map<int,std::set<OIS::JoyStickListener*>> jsIDLnr;
-    for (auto p : mJoySticks)
-        jsIDLnr.insert(std::make_pair(p.first->getID(),p.second->_getListeners()));   
+    if (onlyIfChanged && mBindings.revision == mSavedBindingRevision && s.getPath() == mSavedBindingPath)
+        return;
 
-    // Copy mouse limit
-    int mlw = 0; int mlh = 0;
-    bool hadMouse = mMouse;
-    if (mMouse)
-    {
-        mlw = mMouse->getMouseState().width;
-        mlh = mMouse->getMouseState().height;
-    }
+    s.saveBinding(mBindings);
+    mSavedBindingPath = s.getPath();
+    mSavedBindingRevision = mBindings.revision;
+}
 
-    log::log("Switching exclusive mode: "+std::to_string(exclusive));
 
-    destroyOIS();
-    createOIS(exclusive);
+void Handler::_loadConfig(Serializer& s)
+{
+    s.loadConfig(&mConfig);
+    mSavedConfigPath = s.getPath();
+    mSavedConfig = mConfig;
+}
 
-    // Restore joystick listeners
-    for (auto p : mJoySticks)
-    {
-        auto it = jsIDLnr.find(p.first->getID());
-        if (it == jsIDLnr.end()) continue;
-        p.second->_setListeners(it->second);
-    }
 
-    // Restore mouse limit
-    if (hadMouse && mMouse) setMouseLimit(mlw,mlh);
+void Handler::_saveConfig(Serializer& s, bool onlyIfChanged/* = false*/)
+{
+    if (onlyIfChanged && mConfig == mSavedConfig && s.getPath() == mSavedConfigPath) return;
+
+    s.saveConfig(&mConfig);
+    mSavedConfigPath = s.getPath();
+    mSavedConfig = mConfig;
 }
 
 
-void Handler::processInternalCallback()
+void Handler::_buildBindingListMaps()
 {
-    while (!mInternalCallbacks.empty())
+    counters::add(counters::CNT_REBUILDS);
+    mKeyEvents.reset(KeyEvent::SlotCount);
+    mMouseEvents.reset(MouseEvent::SlotCount);
+    mJoyStickEvents.reset(JoyStickEvent::SlotCountPerJoyStick * mJoySticks.size());
+
+    for (auto& pair : mBindings.map)
     {
-        mInternalCallbacks.front()();
-        mInternalCallbacks.pop();
+        Bind* b = pair.second;
+        _addDispatchEntries(b, b->mKeyEvents, b->mMouseEvents, b->mJoyStickEvents);
+        mBindings.setValue(b->mId, 0.f);
     }
+    _attachSequences();
 }
 
 
-void Handler::createOIS(bool exclusive/* = true*/)
+void Handler::_addDispatchEntries(Bind* b, const Bind::InputEventList& keyEvents,
+    const Bind::InputEventList& mouseEvents, const Bind::InputEventList& joyStickEvents)
 {
-    mIsExclusive = exclusive;
-
-    OIS::ParamList pl;
-    pl.insert({"WINDOW", std::to_string(mWindowID)});
-    
-    if (!mIsExclusive)
-    {
-#if defined OIS_WIN32_PLATFORM
-        pl.insert({"w32_mouse",    "DISCL_FOREGROUND"});
-        pl.insert({"w32_mouse",    "DISCL_NONEXCLUSIVE"});
-        pl.insert({"w32_keyboard", "DISCL_FOREGROUND"});
-        pl.insert({"w32_keyboard", "DISCL_NONEXCLUSIVE"});
-#elif defined OIS_LINUX_PLATFORM
-        pl.insert({"x11_mouse_grab",    "false"});
-        pl.insert({"x11_mouse_hide",    "false"});
-        pl.insert({"x11_keyboard_grab", "false"});
-        pl.insert({"XAutoRepeatOn",     "true"});
-#endif
-    }
+    unsigned source = 0;
+    b->_resetSources(keyEvents.size() + mouseEvents.size() + joyStickEvents.size());
 
-    mOIS = OIS::InputManager::createInputSystem(pl);
-    log::log(mOIS->inputSystemName());
+    for (auto evt : keyEvents)
+        mKeyEvents.add(evt, KeyEvent::getSlot(evt), b, source++);
 
-    log::log("Available device:");
-    for (auto& dev : mOIS->listFreeDevices())
-        log::log("  - "+convertOISDeviceTypeToString(dev.first)+" ("+dev.second+")");
+    for (auto evt : mouseEvents)
+        mMouseEvents.add(evt, MouseEvent::getSlot(evt), b, source++);
 
-    // Create devices
+    for (auto evt : joyStickEvents)
+        mJoyStickEvents.add(evt, JoyStickEvent::getSlot(evt), b, source++);
+}
 
-    if (mOIS->getNumberOfDevices(OIS::OISMouse))
-    {
-        mMouse = static_cast<OIS::Mouse*>(mOIS->createInputObject(OIS::OISMouse, true));
-        mMouse->setEventCallback(this);
-    }
 
-    if (mOIS->getNumberOfDevices(OIS::OISKeyboard))
+void Handler::_mergeBindings(NamedBindingMap& loaded, std::vector<BindingPatch>* patches)
+{
+    auto replace = [&](Bind* b, const Bind::InputEventList& keyEvents,
+        const Bind::InputEventList& mouseEvents, const Bind::InputEventList& joyStickEvents)
     {
-        mKeyboard = static_cast<OIS::Keyboard*>(mOIS->createInputObject(OIS::OISKeyboard, true));
-        mKeyboard->setEventCallback(this);
-    }
+        if (b->mKeyEvents == keyEvents && b->mMouseEvents == mouseEvents &&
+            b->mJoyStickEvents == joyStickEvents) return;
 
-    unsigned numJoystick = mOIS->getNumberOfDevices(OIS::OISJoyStick);
-    if (numJoystick) log::log("Creating joystick:");
+        if (patches)
+        {
+            patches->push_back({b, b->mKeyEvents, b->mMouseEvents, b->mJoyStickEvents,
+                keyEvents, mouseEvents, joyStickEvents});
+        }
+        b->mKeyEvents = keyEvents;
+        b->mMouseEvents = mouseEvents;
+        b->mJoyStickEvents = joyStickEvents;
+        ++mBindings.revision;
+    };
 
-    for (int i = 0; i < mOIS->getNumberOfDevices(OIS::OISJoyStick); i++)
+    for (auto& pair : loaded.map)
     {
-        mJoySticks.push_back(std::make_pair(
-            static_cast<OIS::JoyStick*>(mOIS->createInputObject(OIS::OISJoyStick, true)),
-            new JoyStickListener(this, i)));
+        Bind* from = pair.second;
+        Bind* b = mBindings.getBinding(pair.first, false);
+        replace(b, from->mKeyEvents, from->mMouseEvents, from->mJoyStickEvents);
 
-        auto js = mJoySticks.back().first; 
-        js->setEventCallback(mJoySticks.back().second);
+        // Filters and sequences are compiled by 'update()', no patch needed
+        if (b->mFilters != from->mFilters || b->mSequences != from->mSequences)
+        {
+            b->mFilters = from->mFilters;
+            b->mSequences = from->mSequences;
+            ++mBindings.revision;
+        }
+    }
 
-        // List specs
-        log::log("  - Joystick "+std::to_string(i)+" -- Vendor: "+js->vendor());
-        log::log("    - Unknown: "+js->getNumberOfComponents(OIS::ComponentType::OIS_Unknown));
-        log::log("    - Button: "+js->getNumberOfComponents(OIS::ComponentType::OIS_Button));
-        log::log("    - Axis: "+js->getNumberOfComponents(OIS::ComponentType::OIS_Axis));
-        log::log("    - Slider: "+js->getNumberOfComponents(OIS::ComponentType::OIS_Slider));
-        log::log("    - POV: "+js->getNumberOfComponents(OIS::ComponentType::OIS_POV));
-        log::log("    - Movement capture: "+js->getNumberOfComponents(OIS::ComponentType::OIS_Vector3));
+    const Bind::InputEventList none;
+    for (auto& pair : mBindings.map)
+    {
+        if (loaded.map.count(pair.first)) continue;
+        replace(pair.second, none, none, none);
+        pair.second->clearFilters();
+        pair.second->clearSequences();
     }
+
+    std::vector<Bind*> list;
+    list.swap(loaded.list);
+    loaded.clear();
+    for (auto b : list) delete b;
 }
 
 
-void Handler::destroyOIS()
+void Handler::_editDispatch(Bind* b, DispatchTable& table, unsigned slot, InputEvent::Type evt, bool add)
 {
-    mOIS->destroyInputObject(mKeyboard); mKeyboard = nullptr;
-    mOIS->destroyInputObject(mMouse); mMouse = nullptr;
+    DispatchEdit edit = {b, &table, slot, evt, add};
+    if (mBatchDepth)
+    {
+        mBatchEdits.push_back(edit);
+        return;
+    }
 
-    for (auto& pair : mJoySticks)
+    if (!mThread)
     {
-        mOIS->destroyInputObject(pair.first); // JoyStick
-        delete pair.second; // JoyStickListener
+        _applyEdits(std::vector<DispatchEdit>(1, edit));
+        return;
     }
-    mJoySticks.clear();
 
-    OIS::InputManager::destroyInputSystem(mOIS); mOIS = nullptr;
+    std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+    mInternalCallbacks.push([this, edit](){_applyEdits(std::vector<DispatchEdit>(1, edit));});
 }
 
 
-void Handler::setMouseLimit(int w, int h)
+void Handler::_applyEdits(const std::vector<DispatchEdit>& edits)
 {
-    if (mMouse)
+    // Value of each edited binding before the first edit
+    std::vector<std::pair<Bind*, float>> oldValues;
+    for (auto& edit : edits)
     {
-        log::log("Setting mouse limit: width="+std::to_string(w)+" height="+std::to_string(h)); 
-        mMouse->getMouseState().width = w;
-        mMouse->getMouseState().height = h;
+        Bind* b = edit.bind;
+        auto it = std::find_if(oldValues.begin(), oldValues.end(),
+            [b](const std::pair<Bind*, float>& p){return p.first == b;});
+        if (it == oldValues.end()) oldValues.push_back(std::make_pair(b, b->_getMaxValue()));
+
+        if (edit.add)
+        {
+            edit.table->add(edit.evt, edit.slot, b, b->_addSource());
+            continue;
+        }
+
+        unsigned source = edit.table->remove(edit.evt, edit.slot, b);
+        if (source != DispatchTable::InvalidSource) b->_removeSource(source);
     }
+
+    for (auto& p : oldValues)
+        if (p.first->_getMaxValue() != p.second) _publishValue(p.first, p.second);
 }
 
 
-void Handler::_loadBinding(Serializer& s)
+void Handler::_patchBinding(const BindingPatch& patch)
 {
-    mBindings.clear();
-    s.loadBinding(mBindings);
+    Bind* b = patch.bind;
+    float oldVal = b->_getMaxValue();
+
+    for (auto evt : patch.oldKeyEvents) mKeyEvents.remove(KeyEvent::getSlot(evt), b);
+    for (auto evt : patch.oldMouseEvents) mMouseEvents.remove(MouseEvent::getSlot(evt), b);
+    for (auto evt : patch.oldJoyStickEvents) mJoyStickEvents.remove(JoyStickEvent::getSlot(evt), b);
+
+    _addDispatchEntries(b, patch.keyEvents, patch.mouseEvents, patch.joyStickEvents);
+    _attachSequences();
+
+    // Sources restart from zero
+    if (oldVal != 0.f) _publishValue(b, oldVal);
 }
 
 
-void Handler::_saveBinding(Serializer& s)
+void Handler::_watch(const std::string& path, const std::vector<std::string>& files, const Loader& loader)
 {
-    s.saveBinding(mBindings);
+    unwatch();
+    if (files.empty())
+    {
+        log::log(log::Level::Warning, "Serializer has no file to watch: ", path);
+        return;
+    }
+
+    mWatcher.reset(new FileWatcher(files));
+    if (!mWatcher->isOpen())
+    {
+        mWatcher.reset();
+        return;
+    }
+    mWatchPath = path;
+    mLoader = loader;
 }
 
 
-void Handler::_loadConfig(Serializer& s)
+void Handler::unwatch()
 {
-    s.loadConfig(&mConfig);
+    mWatcher.reset();
+    if (mReload.valid()) mReload.wait();
+    mReload = std::future<std::unique_ptr<LoadedFiles>>();
+    mReloadPending = false;
 }
 
 
-void Handler::_saveConfig(Serializer& s)
+void Handler::_pollReload()
 {
-    s.saveConfig(&mConfig);
+    if (mWatcher->poll()) mReloadPending = true;
+
+    if (mReload.valid())
+    {
+        if (mReload.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        std::unique_ptr<LoadedFiles> loaded = mReload.get();
+        _applyReload(*loaded);
+    }
+
+    if (!mReloadPending) return;
+    mReloadPending = false;
+
+    Loader loader = mLoader;
+    mReload = std::async(std::launch::async, [loader]() -> std::unique_ptr<LoadedFiles>
+    {
+        std::unique_ptr<LoadedFiles> loaded(new LoadedFiles);
+        loader(loaded->bindings, loaded->config);
+        return loaded;
+    });
 }
 
 
-void Handler::_buildBindingListMaps()
+void Handler::_applyReload(LoadedFiles& loaded)
 {
-    mKeyEvents.clear();
-    mMouseEvents.clear();
-    mJoyStickEvents.clear();
+    // New bindings are created here, dispatch entries are patched by the dispatching thread
+    auto patches = std::make_shared<std::vector<BindingPatch>>();
+    _mergeBindings(loaded.bindings, patches.get());
 
-    for (auto& pair : mBindings.map)
+    mSavedBindingPath = mSavedConfigPath = mWatchPath;
+    mSavedBindingRevision = mBindings.revision;
+    mSavedConfig = loaded.config;
+
+    log::log(log::Level::Info, "Reloaded ", mWatchPath, ", ", patches->size(), " binding(s) changed");
+
+    Configuration config = loaded.config;
+    auto apply = [this, patches, config]()
     {
-        Bind* b = pair.second;
+        for (auto& patch : *patches) _patchBinding(patch);
+        mConfig = config;
+    };
+
+    // Keep the order of other binding edits
+    if (!mThread)
+    {
+        apply();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+    mInternalCallbacks.push(apply);
+}
+
+
+/*
+=====================
+BatchEdit
+=====================
+*/
 
-        for (auto evt : b->mKeyEvents)
-            mKeyEvents[evt].push_back(b);
 
-        for (auto evt : b->mMouseEvents)
-            mMouseEvents[evt].push_back(b);
+BatchEdit::~BatchEdit()
+{
+    if (--mHandler->mBatchDepth || mHandler->mBatchEdits.empty()) return;
+
+    auto edits = std::make_shared<std::vector<Handler::DispatchEdit>>();
+    edits->swap(mHandler->mBatchEdits);
 
-        for (auto evt : b->mJoyStickEvents)
-            mJoyStickEvents[evt].push_back(b);
+    if (!mHandler->mThread)
+    {
+        mHandler->_applyEdits(*edits);
+        return;
     }
+
+    Handler* h = mHandler;
+    std::lock_guard<std::mutex> lock(h->mInternalCallbacksMutex);
+    h->mInternalCallbacks.push([h, edits](){h->_applyEdits(*edits);});
 }
 
 
@@ -456,7 +1515,7 @@ void Handler::addJoyStickListener(OIS::JoyStickListener* lnr, int id)
     if (id >= 0 && mJoySticks.size() > (unsigned)id)
         mJoySticks[id].second->addListener(lnr);
     else
-        log::log(std::string(__func__)+" Invalid joystick number", log::Level::Error);
+        log::log(log::Level::Error, __func__, " Invalid joystick number");
 }
 void Handler::removeJoyStickListener(OIS::JoyStickListener* lnr)
 {
@@ -465,13 +1524,21 @@ void Handler::removeJoyStickListener(OIS::JoyStickListener* lnr)
 }
 
 
-Bind::CallbackSharedPtr Handler::callback(
+CallbackHandle Handler::callback(
     const std::string& name,
     const Bind::Callback& cb,
     unsigned type/* = Bind::CT_ON_POSITIVE*/)
 {
-    return getBinding(name)->addCallback(
-        type, Bind::CallbackSharedPtr(new Bind::Callback(cb)));   
+    return mCallbackRegistry->add(getBinding(name), type, cb);
+}
+
+
+CallbackHandle Handler::callback(
+    const BindingName& name,
+    const Bind::Callback& cb,
+    unsigned type/* = Bind::CT_ON_POSITIVE*/)
+{
+    return mCallbackRegistry->add(getBinding(name), type, cb);
 }
 
 
@@ -481,6 +1548,19 @@ Bind* Handler::getBinding(const std::string& name, bool forUse/* = true*/)
 }
 
 
+Bind* Handler::getBinding(const BindingName& name, bool forUse/* = true*/)
+{
+    return mBindings.getBinding(name, forUse);
+}
+
+
+void Handler::getValues(const BindId* ids, unsigned count, float* values) const
+{
+    const float* src = mBindings.values.data();
+    for (unsigned i = 0; i < count; i++) values[i] = src[ids[i]];
+}
+
+
 float Handler::getJoyStickValue(InputEvent::Type evt) const
 {
     float value = 0.f;
@@ -488,7 +1568,7 @@ float Handler::getJoyStickValue(InputEvent::Type evt) const
     unsigned component = JoyStickEvent::getComponent(evt);
     unsigned componentId = JoyStickEvent::getComponentId(evt);
 
-    if (joystickNum >= mJoySticks.size()) return value;
+    if (joystickNum >= mJoySticks.size() || !mJoySticks[joystickNum].first) return value;
     OIS::JoyStick* js = mJoySticks[joystickNum].first;
     const OIS::JoyStickState& state = js->getJoyStickState();
 
@@ -526,14 +1606,185 @@ float Handler::getJoyStickValue(InputEvent::Type evt) const
 }
 
 
-void Handler::setBindingValue(InputEventBindingListMap& bindings, unsigned evt, float value)
+void Handler::setBindingValue(const DispatchTable& table, unsigned slot, float value)
+{
+    counters::add(counters::CNT_DISPATCH_PROBES);
+    if (!table.isBound(slot))
+    {
+        counters::add(counters::CNT_DISPATCH_MISSES);
+        return;
+    }
+
+    for (auto& entry : table.at(slot))
+    {
+        Bind* b = entry.bind;
+        float oldVal = b->_getMaxValue();
+        if (b->setValue(entry.source, value * entry.sign)) _publishValue(b, oldVal);
+    }
+}
+
+
+void Handler::_publishValue(Bind* b, float oldVal)
+{
+    float val = b->_getMaxValue();
+    unsigned type = Bind::getCallbackType(oldVal, val);
+
+    if (mThread)
+    {
+        mThread->setValue(b->mId, val);
+        if (type != Bind::CT_COUNT) mThread->pushCallback(b->mId, type);
+    }
+    else
+    {
+        mBindings.setValue(b->mId, val);
+#ifdef OISM_ENABLE_LATENCY
+        if (mEventStamp.time) _recordLatency(b, LT_VALUE, mEventStamp);
+        if (mEventStamp.time && type != Bind::CT_COUNT && !b->mCallbacks[type].empty())
+            _recordLatency(b, LT_CALLBACK, mEventStamp);
+#endif
+        if (type != Bind::CT_COUNT) b->doCallback(type);
+    }
+
+    if (mSequences && type != Bind::CT_COUNT) _advanceSequences(b, type);
+}
+
+
+void Handler::_compileSequences()
+{
+    auto sequences = std::make_shared<SequenceSet>();
+    std::vector<std::vector<unsigned>> steps;
+
+    // Steps may create bindings, the list can grow meanwhile
+    for (unsigned i = 0; i < mBindings.list.size(); i++)
+    {
+        Bind* b = mBindings.list[i];
+        if (b->mSequences.empty()) continue;
+
+        unsigned owner = sequences->owners.size();
+        sequences->owners.push_back(b);
+        for (auto& sequence : b->mSequences)
+        {
+            steps.clear();
+            for (auto& step : sequence.steps)
+            {
+                steps.push_back(std::vector<unsigned>());
+                for (auto& name : step)
+                {
+                    Bind* stepBind = mBindings.getBinding(name, false);
+                    if (stepBind->mKeyEvents.empty() && stepBind->mMouseEvents.empty() &&
+                        stepBind->mJoyStickEvents.empty() && stepBind->mSequences.empty())
+                        log::log(log::Level::Warning, "Sequence of binding '", *mBindings.names[b->mId],
+                            "' use binding '", name, "' without input");
+                    steps.back().push_back(stepBind->mId);
+                }
+            }
+            if (!sequences->matcher.add(owner, steps, sequence.window))
+                log::log(log::Level::Error, "Invalid sequence for binding '", *mBindings.names[b->mId],
+                    "', empty or too many chord orders");
+        }
+    }
+    mSequenceRevision = mBindings.revision;
+
+    if (sequences->matcher.empty())
+    {
+        if (!mSequences) return;
+        sequences.reset();
+    }
+    else sequences->matcher.compile();
+
+    if (!mThread)
+    {
+        _installSequences(sequences);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mInternalCallbacksMutex);
+    mInternalCallbacks.push([this, sequences](){_installSequences(sequences);});
+}
+
+
+void Handler::_installSequences(const std::shared_ptr<SequenceSet>& sequences)
+{
+    // Release the bindings losing their sequences
+    if (mSequences)
+    {
+        for (auto b : mSequences->owners)
+        {
+            if (b->mSequenceSource == DispatchTable::InvalidSource) continue;
+            if (sequences && std::count(sequences->owners.begin(), sequences->owners.end(), b)) continue;
+
+            float oldVal = b->_getMaxValue();
+            b->_removeSource(b->mSequenceSource);
+            b->mSequenceSource = DispatchTable::InvalidSource;
+            if (b->_getMaxValue() != oldVal) _publishValue(b, oldVal);
+        }
+    }
+
+    mSequences = sequences;
+    _attachSequences();
+}
+
+
+void Handler::_attachSequences()
+{
+    if (!mSequences) return;
+    for (auto b : mSequences->owners)
+        if (b->mSequenceSource == DispatchTable::InvalidSource) b->mSequenceSource = b->_addSource();
+}
+
+
+void Handler::_advanceSequences(Bind* b, unsigned callbackType)
+{
+    SequenceSet& sequences = *mSequences;
+    SequenceMatcher& matcher = sequences.matcher;
+    if (!matcher.isSymbol(b->mId)) return;
+
+    // Owners are published after, they may be part of a sequence too and
+    // advance the matcher again, stacking their owners after these
+    const unsigned first = mCompletedSequences.size();
+    float value;
+    if (callbackType == Bind::CT_ON_POSITIVE)
+    {
+        auto& owners = matcher.press(b->mId, _getEventTime());
+        mCompletedSequences.insert(mCompletedSequences.end(), owners.begin(), owners.end());
+        value = 1.f;
+    }
+    else if (callbackType == Bind::CT_ON_CENTER)
+    {
+        auto& owners = matcher.release(b->mId);
+        mCompletedSequences.insert(mCompletedSequences.end(), owners.begin(), owners.end());
+        value = 0.f;
+    }
+    else return;
+
+    const unsigned last = mCompletedSequences.size();
+    for (unsigned i = first; i < last; i++)
+    {
+        Bind* ob = sequences.owners[mCompletedSequences[i]];
+        float oldVal = ob->_getMaxValue();
+        if (ob->setValue(ob->mSequenceSource, value)) _publishValue(ob, oldVal);
+    }
+    mCompletedSequences.resize(first);
+}
+
+
+#ifdef OISM_ENABLE_LATENCY
+void Handler::_recordLatency(Bind* b, LatencyType type, const LatencyStamp& stamp)
 {
-    auto it = bindings.find(evt);
-    if (it == bindings.end()) return;
+    unsigned long long ns = latency_now() - stamp.time;
+    mLatency[stamp.device][type].record(ns);
+    b->mLatency[type].record(ns);
+}
+
 
-    for (auto binding : it->second)
-        binding->setValue(this, value);
+void Handler::resetLatency()
+{
+    for (auto& device : mLatency)
+        for (auto& histogram : device) histogram.reset();
+    for (auto b : mBindings.list)
+        for (auto& histogram : b->mLatency) histogram.reset();
 }
+#endif
 
 
 void Handler::clearMouseValue()
@@ -546,47 +1797,56 @@ void Handler::clearMouseValue()
 }
 
 
+// Reversed and normal events share the same slot, the sign is stored in the entry
+
 void Handler::setMouseValue(unsigned cpnt, float value)
 {
-    auto evt = MouseEvent::create(cpnt);
-    setBindingValue(mMouseEvents, evt, value);
-
-    MouseEvent::setReverse(evt);
-    setBindingValue(mMouseEvents, evt, -value);
+    setBindingValue(mMouseEvents, MouseEvent::getSlot(MouseEvent::create(cpnt)), value);
 }
 
 
-void Handler::setKeyboardValue(const OIS::KeyEvent& key, float value)
+void Handler::setKeyboardValue(InputEvent::Type evt, float value)
 {
-    auto evt = KeyEvent::create2(key, mKeyboard);
-    setBindingValue(mKeyEvents, evt, value);
+    setBindingValue(mKeyEvents, KeyEvent::getSlot(evt), value);
+}
+
 
-    KeyEvent::setReverse(evt);
-    setBindingValue(mKeyEvents, evt, -value);
+void Handler::setJoyStickValue(OIS::ComponentType cpntType, unsigned cpnt, unsigned joystick, float value)
+{
+    setBindingValue(mJoyStickEvents,
+        JoyStickEvent::getSlot(JoyStickEvent::create(cpntType, cpnt, joystick)), value);
 }
 
 
-void Handler::setJoyStickValue(OIS::ComponentType cpntType, unsigned cpnt, JoyStickListener* lnr, float value)
+void Handler::setMouseRelative(int relX, int relY, int relZ)
 {
-    auto evt = JoyStickEvent::create(cpntType, cpnt, lnr->getId());
-    setBindingValue(mJoyStickEvents, evt, value);
-    
-    JoyStickEvent::setReverse(evt);
-    setBindingValue(mJoyStickEvents, evt, -value);
+    _setMouseRelative(relX * mConfig.mouseSensivityAxisX,
+                      relY * mConfig.mouseSensivityAxisY,
+                      relZ * mConfig.mouseSensivityAxisZ);
 }
 
 
-// ================
-// Inplement OIS::MouseListener
-// ================
+void Handler::_accumulateMouseRelative(int relX, int relY, int relZ)
+{
+    // Scaled before summing, fractions of a count aren't lost
+    mMouseAccumX += relX * mConfig.mouseSensivityAxisX;
+    mMouseAccumY += relY * mConfig.mouseSensivityAxisY;
+    mMouseAccumZ += relZ * mConfig.mouseSensivityAxisZ;
+    mMouseAccumulated = true;
+}
 
 
-bool Handler::mouseMoved(const OIS::MouseEvent& evt)
+void Handler::_flushMouseRelative()
 {
-    float x = evt.state.X.rel * mConfig.mouseSensivityAxisX;
-    float y = evt.state.Y.rel * mConfig.mouseSensivityAxisY;
-    float z = evt.state.Z.rel * mConfig.mouseSensivityAxisZ;
+    if (!mMouseAccumulated) return;
+    _setMouseRelative(mMouseAccumX, mMouseAccumY, mMouseAccumZ);
+    mMouseAccumX = mMouseAccumY = mMouseAccumZ = 0.f;
+    mMouseAccumulated = false;
+}
 
+
+void Handler::_setMouseRelative(float x, float y, float z)
+{
     if (x != mMouseLastRelativeX)
     {
         mMouseRelativeUpdatedX = true;
@@ -620,7 +1880,65 @@ bool Handler::mouseMoved(const OIS::MouseEvent& evt)
     mMouseLastRelativeX = x;
     mMouseLastRelativeY = y;
     mMouseLastRelativeZ = z;
+}
+
+
+// ================
+// Event injection
+// ================
+
 
+void Handler::injectKey(unsigned key, unsigned modifiers, bool pressed)
+{
+    setKeyboardValue(KeyEvent::create(key, modifiers, false), pressed ? 1.f : 0.f);
+}
+
+
+void Handler::injectMouseButton(unsigned button, bool pressed)
+{
+    setMouseValue(button, pressed ? 1.f : 0.f);
+}
+
+
+void Handler::injectMouseMove(int relX, int relY, int relZ/* = 0*/)
+{
+    setMouseRelative(relX, relY, relZ);
+}
+
+
+void Handler::injectJoyStickButton(unsigned joystick, unsigned button, bool pressed)
+{
+    setJoyStickValue(OIS::ComponentType::OIS_Button, button, joystick, pressed ? 1.f : 0.f);
+}
+
+
+void Handler::injectJoyStickAxis(unsigned joystick, unsigned axis, int value)
+{
+    setJoyStickValue(OIS::ComponentType::OIS_Axis, axis, joystick,
+        JoyStickEvent::normalizeAxisValue(value));
+}
+
+
+void Handler::injectJoyStickPov(unsigned joystick, unsigned idx, unsigned direction)
+{
+    // Component ID is even for the vertical direction, see 'JoyStickEvent::getPovDirectionValue()'
+    setJoyStickValue(OIS::ComponentType::OIS_POV, idx * 2 + 1, joystick, JoyStickEvent::directionToHorizontal(direction));
+    setJoyStickValue(OIS::ComponentType::OIS_POV, idx * 2, joystick, JoyStickEvent::directionToVertical(direction));
+}
+
+
+// ================
+// Inplement OIS::MouseListener
+// ================
+
+
+bool Handler::mouseMoved(const OIS::MouseEvent& evt)
+{
+    EventStamp stamp(this, LD_MOUSE);
+    counters::add(counters::CNT_MOUSE_EVENTS);
+    if (mRecorder) mRecorder->mouseMove(evt.state.X.rel, evt.state.Y.rel, evt.state.Z.rel);
+    if (mConfig.mouseCoalesce) _accumulateMouseRelative(evt.state.X.rel, evt.state.Y.rel, evt.state.Z.rel);
+    else setMouseRelative(evt.state.X.rel, evt.state.Y.rel, evt.state.Z.rel);
     for (auto lnr : mMouseListeners) lnr->mouseMoved(evt);
     return true;
 }
@@ -628,6 +1946,9 @@ bool Handler::mouseMoved(const OIS::MouseEvent& evt)
 
 bool Handler::mousePressed(const OIS::MouseEvent& evt, OIS::MouseButtonID id)
 {
+    EventStamp stamp(this, LD_MOUSE);
+    counters::add(counters::CNT_MOUSE_EVENTS);
+    if (mRecorder) mRecorder->mouseButton(id, true);
     setMouseValue((unsigned)id, 1.f);
     for (auto lnr : mMouseListeners) lnr->mousePressed(evt, id);
     return true;
@@ -636,6 +1957,9 @@ bool Handler::mousePressed(const OIS::MouseEvent& evt, OIS::MouseButtonID id)
 
 bool Handler::mouseReleased(const OIS::MouseEvent& evt, OIS::MouseButtonID id)
 {
+    EventStamp stamp(this, LD_MOUSE);
+    counters::add(counters::CNT_MOUSE_EVENTS);
+    if (mRecorder) mRecorder->mouseButton(id, false);
     setMouseValue((unsigned)id, 0.f);
     for (auto lnr : mMouseListeners) lnr->mouseReleased(evt, id);
     return true;
@@ -649,7 +1973,11 @@ bool Handler::mouseReleased(const OIS::MouseEvent& evt, OIS::MouseButtonID id)
 
 bool Handler::keyPressed(const OIS::KeyEvent& evt)
 {
-    setKeyboardValue(evt, 1.f);
+    EventStamp stamp(this, LD_KEYBOARD);
+    counters::add(counters::CNT_KEYBOARD_EVENTS);
+    InputEvent::Type keyEvt = KeyEvent::create2(evt, mKeyboard);
+    if (mRecorder) mRecorder->key(KeyEvent::getKey(keyEvt), KeyEvent::getModifier(keyEvt), true);
+    setKeyboardValue(keyEvt, 1.f);
     for (auto lnr : mKeyListeners) lnr->keyPressed(evt);
     return true;
 }
@@ -657,7 +1985,11 @@ bool Handler::keyPressed(const OIS::KeyEvent& evt)
 
 bool Handler::keyReleased(const OIS::KeyEvent& evt)
 {
-    setKeyboardValue(evt, 0.f);
+    EventStamp stamp(this, LD_KEYBOARD);
+    counters::add(counters::CNT_KEYBOARD_EVENTS);
+    InputEvent::Type keyEvt = KeyEvent::create2(evt, mKeyboard);
+    if (mRecorder) mRecorder->key(KeyEvent::getKey(keyEvt), KeyEvent::getModifier(keyEvt), false);
+    setKeyboardValue(keyEvt, 0.f);
     for (auto lnr : mKeyListeners) lnr->keyReleased(evt);
     return true;
 }
@@ -670,29 +2002,37 @@ bool Handler::keyReleased(const OIS::KeyEvent& evt)
 
 void Handler::buttonPressed(unsigned button, JoyStickListener* lnr)
 {
-    setJoyStickValue(OIS::ComponentType::OIS_Button, button, lnr, 1.f);
+    EventStamp stamp(this, LD_JOYSTICK);
+    counters::add(counters::CNT_JOYSTICK_EVENTS);
+    if (mRecorder) mRecorder->joyStickButton(lnr->getId(), button, true);
+    setJoyStickValue(OIS::ComponentType::OIS_Button, button, lnr->getId(), 1.f);
 }
 
 
 void Handler::buttonReleased(unsigned button, JoyStickListener* lnr)
 {
-    setJoyStickValue(OIS::ComponentType::OIS_Button, button, lnr, 0.f);
+    EventStamp stamp(this, LD_JOYSTICK);
+    counters::add(counters::CNT_JOYSTICK_EVENTS);
+    if (mRecorder) mRecorder->joyStickButton(lnr->getId(), button, false);
+    setJoyStickValue(OIS::ComponentType::OIS_Button, button, lnr->getId(), 0.f);
 }
 
 
-void Handler::axisMoved(unsigned axis, float value, JoyStickListener* lnr)
+void Handler::axisMoved(unsigned axis, int value, JoyStickListener* lnr)
 {
-    setJoyStickValue(OIS::ComponentType::OIS_Axis, axis, lnr, value);
+    EventStamp stamp(this, LD_JOYSTICK);
+    counters::add(counters::CNT_JOYSTICK_EVENTS);
+    if (mRecorder) mRecorder->joyStickAxis(lnr->getId(), axis, value);
+    setJoyStickValue(OIS::ComponentType::OIS_Axis, axis, lnr->getId(), JoyStickEvent::normalizeAxisValue(value));
 }
 
 
 void Handler::povMoved(unsigned idx, unsigned direction, JoyStickListener* lnr)
 {
-    float horizontalValue = JoyStickEvent::directionToHorizontal(direction);
-    float verticalValue = JoyStickEvent::directionToVertical(direction);
-
-    setJoyStickValue(OIS::ComponentType::OIS_POV, idx, lnr, horizontalValue);
-    setJoyStickValue(OIS::ComponentType::OIS_POV, idx, lnr, verticalValue);
+    EventStamp stamp(this, LD_JOYSTICK);
+    counters::add(counters::CNT_JOYSTICK_EVENTS);
+    if (mRecorder) mRecorder->joyStickPov(lnr->getId(), idx, direction);
+    injectJoyStickPov(lnr->getId(), idx, direction);
 }
 
 
@@ -4,6 +4,15 @@
 #pragma once 
 
 #include "OISMfwdcl.h"
+#include "OISMAxisBatch.h"
+#include "OISMCounters.h"
+#include "OISMDeviceBackend.h"
+#include "OISMFilter.h"
+#include "OISMJoyStickHotplug.h"
+#include "OISMLatency.h"
+#include "OISMLog.h"
+#include "OISMRecorder.h"
+#include "OISMSequence.h"
 
 #include <OISEvents.h>
 #include <OISInputManager.h>
@@ -11,18 +20,23 @@
 #include <OISKeyboard.h>
 #include <OISMouse.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <deque>
 #include <functional>
+#include <future>
 #include <queue>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
 
 // NOTE: Bit shifting assume at least 32bits, little-endian machine
@@ -33,47 +47,6 @@ namespace oism
 {
 
 
-namespace log
-{
-
-    enum class Level
-    {
-        Info,
-        Warning,
-        Error
-    };
-
-    typedef std::function<void(const std::string&, Level)> Func_t;
-    extern Func_t g_Func;
-
-    /// Set logger
-    inline void set(const Func_t& func) { g_Func = func; }
-
-#ifdef OISM_ENABLE_LOG
-    /// Safe to use on empty function + default parameter
-    inline void log(const std::string& msg, Level lvl = Level::Info)
-    {
-        if (g_Func)
-            g_Func(msg,lvl);
-    }
-#else // OISM_ENABLE_LOG
-    inline void log(const std::string& msg, Level lvl = Level::Info) {}
-#endif // OISM_ENABLE_LOG
-
-    inline std::string to_string(Level lvl)
-    {
-        switch (lvl)
-        {
-            case Level::Info: return "";
-            case Level::Warning: return "WARNING | ";
-            case Level::Error: return "== ERROR == | ";
-        }
-        return "";
-    }
-
-} // namespace log
-
-
 class NonCopyable
 {
 protected:
@@ -141,13 +114,36 @@ struct KeyEvent : public InputEvent
     {
         return getByte(evt, KeyByte);
     }
+
+    // OIS modifiers don't fit in a byte ('Alt' is 0x100), they are packed
+    // as 'Shift' bit 0, 'Ctrl' bit 1 and 'Alt' bit 2.
     static void setModifier(InputEvent::Type& evt, unsigned mod)
     {
-        setByte(evt, mod, ModifierByte);
+        setByte(evt, packModifier(mod), ModifierByte);
     }
     static unsigned getModifier(InputEvent::Type evt)
     {
-        return getByte(evt, ModifierByte);
+        return unpackModifier(getByte(evt, ModifierByte));
+    }
+    static unsigned packModifier(unsigned mod)
+    {
+        return (mod & OIS::Keyboard::Shift ? 1 : 0) |
+               (mod & OIS::Keyboard::Ctrl ? 2 : 0) |
+               (mod & OIS::Keyboard::Alt ? 4 : 0);
+    }
+    static unsigned unpackModifier(unsigned packed)
+    {
+        return (packed & 1 ? OIS::Keyboard::Shift : 0) |
+               (packed & 2 ? OIS::Keyboard::Ctrl : 0) |
+               (packed & 4 ? OIS::Keyboard::Alt : 0);
+    }
+
+    // Dispatch table index, reverse flag excluded
+    static const unsigned ModifierCount = 8;
+    static const unsigned SlotCount = 256 * ModifierCount;
+    static unsigned getSlot(InputEvent::Type evt)
+    {
+        return getKey(evt) * ModifierCount + (getByte(evt, ModifierByte) & (ModifierCount - 1));
     }
 
     static void addModifier(unsigned& mod, unsigned newMod)
@@ -179,6 +175,12 @@ struct MouseEvent : public InputEvent
         return getByte(evt, ComponentByte);
     }
 
+    // Dispatch table index, reverse flag excluded
+    static unsigned getSlot(Type evt)
+    {
+        return getComponent(evt);
+    }
+
     enum Component
     {
         CPNT_LEFT = OIS::MB_Left,
@@ -193,8 +195,11 @@ struct MouseEvent : public InputEvent
 
         CPNT_AXIS_X,
         CPNT_AXIS_Y,
-        CPNT_AXIS_Z // Mouse wheel
+        CPNT_AXIS_Z, // Mouse wheel
+        CPNT_COUNT
     };
+
+    static const unsigned SlotCount = CPNT_COUNT;
 };
 
 
@@ -239,6 +244,18 @@ struct JoyStickEvent : public InputEvent
         return getByte(evt, ComponentIdByte);
     }
 
+    // Dispatch table index, reverse flag excluded.
+    // Joystick number is the outermost dimension so the table only grows
+    // with the highest joystick number in use.
+    static const unsigned ComponentCount = OIS::OIS_Vector3 + 1;
+    static const unsigned ComponentIdCount = 256;
+    static const unsigned SlotCountPerJoyStick = ComponentCount * ComponentIdCount;
+    static unsigned getSlot(Type evt)
+    {
+        return (getJoystickNumber(evt) * ComponentCount + getComponent(evt)) * ComponentIdCount +
+            getComponentId(evt);
+    }
+
     static float getPovDirectionValue(unsigned dir, unsigned componentId)
     {
         return componentId & 1 ?
@@ -298,9 +315,9 @@ struct DefaultEvent
                joyStickEvents.empty();
     }
 
-    std::list<InputEvent::Type> keyEvents;
-    std::list<InputEvent::Type> mouseEvents;
-    std::list<InputEvent::Type> joyStickEvents;
+    std::vector<InputEvent::Type> keyEvents;
+    std::vector<InputEvent::Type> mouseEvents;
+    std::vector<InputEvent::Type> joyStickEvents;
 };
 
 
@@ -316,6 +333,7 @@ public:
 
     const std::set<OIS::JoyStickListener*>& _getListeners() { return mListeners; }
     void _setListeners(const std::set<OIS::JoyStickListener*>& lnr) { mListeners = lnr; }
+    void _resetAxes() { mLastAxes.assign(mLastAxes.size(), 0); } //!< Bindings were released
 
 protected:
     bool buttonPressed(const OIS::JoyStickEvent& evt, int button);
@@ -323,22 +341,107 @@ protected:
     bool axisMoved(const OIS::JoyStickEvent& evt, int axis);
     bool povMoved(const OIS::JoyStickEvent& evt, int idx);
 
+    /// Apply the axis filter, return false if the change isn't dispatched
+    bool _filterAxis(unsigned axis, int& value);
+
     Handler* mHandler;
     int mId;
     std::set<OIS::JoyStickListener*> mListeners;
+    std::vector<int> mLastAxes; //!< Last dispatched values
+};
+
+
+//! Lightweight handle to a registered callback.
+//! The callback is disabled when the handle is destroyed or reset.
+class CallbackHandle
+{
+friend class CallbackRegistry;
+
+public:
+    CallbackHandle() : mIndex(0), mGeneration(0) {}
+    CallbackHandle(CallbackHandle&& other);
+    ~CallbackHandle() { reset(); }
+
+    CallbackHandle& operator=(CallbackHandle&& other);
+
+    void reset(); //!< Disable the callback
+    bool isValid() const;
+
+private:
+    CallbackHandle(const CallbackHandle&);
+    CallbackHandle& operator=(const CallbackHandle&);
+    CallbackHandle(const std::shared_ptr<CallbackRegistry>& registry, unsigned index, unsigned generation)
+    :   mRegistry(registry), mIndex(index), mGeneration(generation) {}
+
+    std::weak_ptr<CallbackRegistry> mRegistry; // Only locked on removal
+    unsigned mIndex;
+    unsigned mGeneration;
 };
 
 
+//! Generation-indexed slot map of callbacks.
+//! Callbacks are stored densely in the binding they belong to, slots keep
+//! track of their position so removal is O(1). Removal and addition during
+//! a dispatch are deferred until the outermost dispatch returns, but a
+//! removed callback is never called again.
+class CallbackRegistry : NonCopyable, public std::enable_shared_from_this<CallbackRegistry>
+{
+public:
+    typedef std::function<void()> Callback;
+
+    struct Entry
+    {
+        Callback func;
+        unsigned slot;
+        bool active;
+    };
+    typedef std::vector<Entry> EntryList;
+
+    CallbackRegistry() : mDispatchDepth(0) {}
+
+    CallbackHandle add(Bind* b, unsigned callbackType, const Callback& cb);
+    void remove(unsigned index, unsigned generation);
+    bool isValid(unsigned index, unsigned generation) const
+    {
+        return index < mSlots.size() && mSlots[index].generation == generation && mSlots[index].list;
+    }
+
+    void dispatch(EntryList& list);
+
+protected:
+    struct Slot
+    {
+        unsigned generation;
+        EntryList* list; //!< null when free
+        unsigned dense; //!< Index in 'list'
+    };
+
+    void _insert(unsigned slot, const Callback& cb);
+    void _erase(unsigned slot);
+    void _processPending();
+
+    std::vector<Slot> mSlots;
+    std::vector<unsigned> mFreeSlots;
+
+    unsigned mDispatchDepth;
+    std::vector<std::pair<unsigned, Callback>> mPendingInsert;
+    std::vector<unsigned> mPendingErase;
+};
+
+
+//! Stable index of a binding, see 'NamedBindingMap::list'
+typedef unsigned BindId;
+
+
 class Bind
 {
 friend class Handler;
+friend class CallbackRegistry;
+friend struct NamedBindingMap;
 
 public:
-    typedef std::function<void()> Callback;
-    typedef std::shared_ptr<Callback> CallbackSharedPtr;
-    typedef std::weak_ptr<Callback> CallbackWeakPtr;
-    typedef std::list<CallbackWeakPtr> CallbackWeakPtrList;
-    typedef std::list<InputEvent::Type> InputEventList;
+    typedef CallbackRegistry::Callback Callback;
+    typedef std::vector<InputEvent::Type> InputEventList;
 
     enum CallbackType
     {
@@ -348,19 +451,28 @@ public:
         CT_COUNT
     };
 
-    Bind() : mValue(0.f) {}
+    Bind() : mId(0), mValues(nullptr), mRevision(nullptr), mHandler(nullptr), mCallbackRegistry(nullptr)
+        { _resetSources(0); }
     Bind(const DefaultEvent& def)
     :   mKeyEvents(def.keyEvents),
         mMouseEvents(def.mouseEvents),
         mJoyStickEvents(def.joyStickEvents),
-        mValue(0.f)
-    {}
+        mId(0),
+        mValues(nullptr),
+        mRevision(nullptr),
+        mHandler(nullptr),
+        mCallbackRegistry(nullptr)
+    {
+        _resetSources(0);
+    }
 
-    const CallbackSharedPtr& addCallback(unsigned callbackType, const CallbackSharedPtr& cb);
-    inline float getValue() const { return mValue; }
+    /// Published value, zero if the binding doesn't belong to a map
+    inline float getValue() const { return mValues ? (*mValues)[mId] : 0.f; }
+    inline BindId getId() const { return mId; }
 
     /// @name Modifiers
-    /// Apply change by calling 'Handler::_buildBindingListMaps()'.
+    /// Bindings owned by a handler update its dispatch tables immediately,
+    /// use 'BatchEdit' to publish several edits at once.
     ///@{
     void addKeyEvent(InputEvent::Type evt);
     void addMouseEvent(InputEvent::Type evt);
@@ -370,42 +482,238 @@ public:
     void removeJoyStickEvent(InputEvent::Type evt);
     ///@}
 
+    /// @name Analog filters
+    /// Stages are applied in order to the published value once per 'Handler::update()'.
+    ///@{
+    void addFilter(const FilterStage& stage);
+    void clearFilters();
+    const FilterChain& getFilters() const { return mFilters; }
+    ///@}
+
+    /// @name Sequences
+    /// The binding is pressed when the bindings of a sequence are pressed in order
+    /// within its window, and released with any binding of the last step.
+    /// Sequences are compiled by the next 'Handler::update()'.
+    ///@{
+    void addSequence(const BindSequence& sequence);
+    void clearSequences();
+    const std::vector<BindSequence>& getSequences() const { return mSequences; }
+    ///@}
+
     const InputEventList& getKeyEvents() {return mKeyEvents;}
     const InputEventList& getMouseEvents() {return mMouseEvents;}
     const InputEventList& getJoyStickEvents() {return mJoyStickEvents;}
 
-    float _getMaxValue(Handler*) const; //>! Return farthest value from zero
+#ifdef OISM_ENABLE_LATENCY
+    /// Device events changing this binding, see 'Handler::getLatency()'
+    const LatencyHistogram& getLatency(LatencyType type) const { return mLatency[type]; }
+#endif
+
+    /// Return farthest source value from zero
+    inline float _getMaxValue() const { return mSources[mMaxTree[1]]; }
+
+    /// Number of sources is the number of key, mouse and joystick events, in that order.
+    /// All source values are reset to zero.
+    void _resetSources(unsigned count);
+    /// @name Single source edit
+    /// Indices of other sources don't change, removed indices are reused.
+    ///@{
+    unsigned _addSource();
+    void _removeSource(unsigned source);
+    ///@}
+
+    /// Callback triggered by a value change, 'CT_COUNT' if none
+    static unsigned getCallbackType(float oldVal, float newVal)
+    {
+        if (oldVal == 0.f)
+        {
+            if (newVal > 0.f) return CT_ON_POSITIVE;
+            if (newVal < 0.f) return CT_ON_NEGATIVE;
+        }
+        else if (newVal == 0.f) return CT_ON_CENTER;
+        return CT_COUNT;
+    }
 
 protected:
-    void setValue(Handler*, float); //>! Used by friend class 'Handler'
+    /// Return true if the farthest value changed.
+    /// Used by friend class 'Handler', which publish the value.
+    bool setValue(unsigned source, float);
     InputEventList mKeyEvents;
     InputEventList mMouseEvents;
     InputEventList mJoyStickEvents;
+    FilterChain mFilters;
+    std::vector<BindSequence> mSequences;
 
 private:
     void doCallback(unsigned callbackType);
     void clipValue();
 
-    std::array<CallbackWeakPtrList, CT_COUNT> mCallbacks;
-    float mValue;
+    // Last value of each source, padded with zeros to a power of two
+    std::vector<float> mSources;
+    // Tournament tree of the source index with the farthest value from zero,
+    // leaves start at 'mSources.size()' and the winner is at index 1.
+    std::vector<unsigned> mMaxTree;
+    unsigned mSourceCount; //!< Sources in use or freed
+    std::vector<unsigned> mFreeSources;
+    unsigned mSequenceSource; //!< Source set by the sequences, 'DispatchTable::InvalidSource' if none
+
+    BindId mId;
+    const std::vector<float>* mValues; //!< 'NamedBindingMap::values'
+    unsigned* mRevision; //!< 'NamedBindingMap::revision'
+    Handler* mHandler; //!< Owner of the dispatch tables
+    std::array<CallbackRegistry::EntryList, CT_COUNT> mCallbacks;
+    CallbackRegistry* mCallbackRegistry; //!< Set on first callback
+#ifdef OISM_ENABLE_LATENCY
+    LatencyHistogram mLatency[LT_COUNT];
+#endif
+};
+
+
+//! Direct-indexed table of the bindings driven by each input slot.
+//! A bitmap rejects unbound slots before touching the entries.
+class DispatchTable
+{
+public:
+    struct Entry
+    {
+        Bind* bind;
+        unsigned source; //!< Source index in the binding
+        float sign; //!< -1 for reversed event
+    };
+    typedef std::vector<Entry> EntryList;
+
+    void reset(unsigned slotCount);
+    void add(InputEvent::Type evt, unsigned slot, Bind* b, unsigned source);
+    void remove(unsigned slot, Bind* b); //!< Remove every entry of 'b' in the slot
+    /// Remove one entry of 'b' for 'evt', return its source or 'InvalidSource'
+    unsigned remove(InputEvent::Type evt, unsigned slot, Bind* b);
+    static const unsigned InvalidSource = ~0u;
+
+    inline bool isBound(unsigned slot) const
+    {
+        return slot < mSlots.size() && (mBitmap[slot >> 5] & (1u << (slot & 31)));
+    }
+    inline const EntryList& at(unsigned slot) const { return mSlots[slot]; }
+
+protected:
+    std::vector<unsigned> mBitmap;
+    std::vector<EntryList> mSlots;
+};
+
+
+//! Binding name hashed with FNV-1a. The hash is only computed at compile time for a
+//! constant, eg. 'static constexpr oism::BindingName walk("walk");', otherwise at run time.
+//! Only keep a pointer to the name, it must outlive the BindingName.
+struct BindingName
+{
+    template <unsigned N>
+    constexpr explicit BindingName(const char (&name)[N])
+    :   hash(hashString(name)), str(name) {}
+
+    explicit BindingName(const std::string& name)
+    :   hash(hashRuntime(name.c_str())), str(name.c_str()) {}
+
+    static constexpr unsigned hashString(const char* s, unsigned h = 2166136261u)
+    {
+        return *s ? hashString(s + 1, ((h ^ (unsigned char)*s) * 16777619u) & 0xffffffffu) : h;
+    }
+    static unsigned hashRuntime(const char* s)
+    {
+        unsigned h = 2166136261u;
+        for (; *s; ++s) h = ((h ^ (unsigned char)*s) * 16777619u) & 0xffffffffu;
+        return h;
+    }
+
+    unsigned hash;
+    const char* str;
+};
+
+
+//! Open addressing table from name hash to binding ID
+class SymbolTable
+{
+public:
+    static const BindId InvalidId = ~0u;
+
+    SymbolTable() : mCount(0) {}
+
+    inline BindId find(unsigned hash) const
+    {
+        if (mSlots.empty()) return InvalidId;
+        unsigned mask = mSlots.size() - 1;
+        for (unsigned i = hash & mask; ; i = (i + 1) & mask)
+        {
+            const Slot& slot = mSlots[i];
+            if (slot.id == InvalidId || slot.hash == hash) return slot.id;
+        }
+    }
+
+    /// Return false if the hash is already used
+    bool insert(unsigned hash, BindId id);
+    void clear() { mSlots.clear(); mCount = 0; }
+
+protected:
+    struct Slot
+    {
+        unsigned hash;
+        BindId id; //!< 'InvalidId' for an empty slot
+    };
+
+    std::vector<Slot> mSlots; //!< Power of two, at most half full
+    unsigned mCount;
 };
 
 
+//! Bindings by name and by ID.
+//! Published values are kept apart from the bindings in a contiguous array,
+//! they are only written on the game thread.
 struct NamedBindingMap
 {
+    NamedBindingMap() : revision(0), handler(nullptr) {}
+
     Bind* getBinding(const std::string& name, bool forUse = true);
-    void clear() { map.clear(); }
+    Bind* getBinding(const BindingName& name, bool forUse = true);
+    void clear();
+
+    /// Filtered bindings publish on the next 'Handler::update()'
+    inline void setValue(BindId id, float value)
+    {
+        if (!filters.setInput(id, value)) setOutput(id, value);
+    }
+    inline void setOutput(BindId id, float value)
+    {
+        values[id] = value;
+        changed[id >> 5] |= 1u << (id & 31);
+    }
+    /// Last value set, before filtering
+    inline float getInput(BindId id) const { return filters.isFiltered(id) ? filters.getInput(id) : values[id]; }
+    inline bool hasChanged(BindId id) const { return changed[id >> 5] & (1u << (id & 31)); }
+    void clearChanged() { std::fill(changed.begin(), changed.end(), 0); }
 
     std::unordered_map<std::string, Bind*> map;
+    SymbolTable symbols; //!< Hashed names
+    std::vector<const std::string*> names; //!< Interned names, indexed by binding ID
+    std::vector<Bind*> list; //!< Indexed by binding ID
+    std::vector<float> values; //!< Indexed by binding ID
+    std::vector<unsigned> changed; //!< Bitset indexed by binding ID, reset by 'Handler::update()'
+    FilterBank filters; //!< Chains of the filtered bindings, built by 'Handler::update()'
+    unsigned revision; //!< Incremented when a binding or its events are added or removed
+    Handler* handler; //!< Set on the bindings, null for a map being loaded
 };
 
 
 class Handler : NonCopyable, public OIS::MouseListener, public OIS::KeyListener
 {
 friend class JoyStickListener;
+friend class InputThread;
+friend class Bind;
+friend class BatchEdit;
+friend class Player;
 
 public:
-    Handler(unsigned long windowID, bool exclusive = true);
+    Handler(unsigned long windowID, bool exclusive = true); //!< OIS devices, see 'OISBackend'
+    Handler(const std::shared_ptr<DeviceBackend>& backend, unsigned long windowID = 0, bool exclusive = true);
+    Handler(); //!< No input system, events are provided with 'inject*()'
     virtual ~Handler();
 
     template<typename Serializer_t>
@@ -417,21 +725,149 @@ public:
         _buildBindingListMaps();
     }
 
+    /// @name Hot reload
+    /// Watch the files read by 'Serializer_t', changes are parsed on a background
+    /// thread and applied on 'update()'. Only the bindings that changed are patched,
+    /// 'Bind' pointers and callbacks stay valid.
+    ///@{
     template<typename Serializer_t>
-    void save(const std::string& path)
+    void watch(const std::string& path)
+    {
+        _watch(path, Serializer_t(path).getFiles(), [path](NamedBindingMap& map, Configuration& c)
+        {
+            Serializer_t s(path);
+            s.loadBinding(map);
+            s.loadConfig(&c);
+        });
+    }
+    void unwatch();
+    bool isWatching() const { return mWatcher.get(); }
+    ///@}
+
+    /// 'onlyIfChanged' skip files whose content didn't change since the last
+    /// load or save at the same path
+    template<typename Serializer_t>
+    void save(const std::string& path, bool onlyIfChanged = false)
     {
         Serializer_t s(path);
-        _saveBinding(s);
-        _saveConfig(s);
+        _saveBinding(s, onlyIfChanged);
+        _saveConfig(s, onlyIfChanged);
     }
 
     void setMouseLimit(int w, int h);
     void setExclusive(bool exclusive = true);
     bool isExclusive() const { return mIsExclusive; }
 
+    /// @name Exclusive mode switch
+    /// The backend switch exclusivity of the existing devices in place when it can,
+    /// see 'OISBackend'. The toggle replaces it, eg. grabbing the pointer with the
+    /// windowing library, and return false if it can't. Otherwise devices are
+    /// recreated, on a background thread if the backend allows it, and swapped in
+    /// by 'update()'; the current devices keep dispatching meanwhile. Bindings and
+    /// listeners are kept.
+    ///@{
+    typedef std::function<bool(bool exclusive)> ExclusiveToggle;
+    void setExclusiveToggle(const ExclusiveToggle& toggle) { mExclusiveToggle = toggle; }
+    /// Create devices on the dispatching thread, for backends requiring it.
+    /// Defaults to 'DeviceBackend::isThreadSafe()', enable it with OIS on Linux
+    /// once 'XInitThreads()' has been called first.
+    void setAsyncDeviceCreation(bool async) { mAsyncDeviceCreation = async; }
+    bool isExclusivePending() const { return mExclusivePending; } //!< Switch not applied yet
+    ///@}
+
+    /// @name Joystick hotplug
+    /// Joysticks are enumerated every 'interval' milliseconds on a background
+    /// thread, see 'DeviceBackend::listJoySticks()', and the changes applied by
+    /// 'update()'. Keyboard, mouse and the joysticks still connected are kept.
+    /// A joystick keep its number while connected and get it back on reconnection,
+    /// by identity: the second of two identical joysticks takes the identity and
+    /// number of the first when it is unplugged.
+    ///@{
+    void enableJoyStickHotplug(unsigned interval = 1000);
+    bool isJoyStickConnected(unsigned joystick) const
+        { return joystick < mJoySticks.size() && mJoySticks[joystick].first; }
+    ///@}
+
     void update();
-    Bind::CallbackSharedPtr callback(const std::string& name, const Bind::Callback& cb, unsigned type = Bind::CT_ON_POSITIVE);
+
+    /// @name Threaded mode
+    /// Devices are captured and events dispatched on a dedicated thread at 'rate' Hz,
+    /// 'update()' then publish the latest binding values and run callbacks.
+    /// 'pump' replace device capture, eg. to provide synthetic events with 'inject*()'.
+    /// Binding edits are queued to the input thread, '_buildBindingListMaps()' must
+    /// not be called while it is running.
+    ///@{
+    typedef std::function<void()> Pump;
+    void startThread(unsigned rate = 1000, const Pump& pump = Pump());
+    void stopThread();
+    bool isThreaded() const { return mThread.get(); }
+    ///@}
+
+    /// @name Event injection
+    /// Go through the same dispatch as device events, without notifying listeners.
+    /// Must be called from the dispatching thread, see 'startThread()'.
+    ///@{
+    void injectKey(unsigned key, unsigned modifiers, bool pressed);
+    void injectMouseButton(unsigned button, bool pressed);
+    void injectMouseMove(int relX, int relY, int relZ = 0);
+    void injectJoyStickButton(unsigned joystick, unsigned button, bool pressed);
+    void injectJoyStickAxis(unsigned joystick, unsigned axis, int value);
+    void injectJoyStickPov(unsigned joystick, unsigned idx, unsigned direction);
+    ///@}
+
+    /// @name Recording
+    /// Device events are written to 'path' with their timing, to be replayed
+    /// by 'Player'. Takes effect on the dispatching thread, the file is complete
+    /// once it processed 'stopRecording()', see 'update()'.
+    ///@{
+    bool startRecording(const std::string& path, unsigned capacity = 65536);
+    void stopRecording();
+    ///@}
+
+#ifdef OISM_ENABLE_LATENCY
+    /// @name Input latency
+    /// Time from a device event reaching the handler to the values and callbacks
+    /// it changed, by device. Injected events aren't measured.
+    ///@{
+    const LatencyHistogram& getLatency(LatencyDevice device, LatencyType type) const
+        { return mLatency[device][type]; }
+    void resetLatency(); //!< Bindings included
+    ///@}
+#endif
+
+    CallbackHandle callback(const std::string& name, const Bind::Callback& cb, unsigned type = Bind::CT_ON_POSITIVE);
+    CallbackHandle callback(const BindingName& name, const Bind::Callback& cb, unsigned type = Bind::CT_ON_POSITIVE);
     Bind* getBinding(const std::string& name, bool forUse = true);
+    Bind* getBinding(const BindingName& name, bool forUse = true);
+
+    /// @name String literals
+    /// Names are hashed on each call without building a std::string,
+    /// pass a constant 'BindingName' to hash them at compile time
+    ///@{
+    template <unsigned N>
+    CallbackHandle callback(const char (&name)[N], const Bind::Callback& cb, unsigned type = Bind::CT_ON_POSITIVE)
+        { return callback(BindingName(name), cb, type); }
+    template <unsigned N>
+    Bind* getBinding(const char (&name)[N], bool forUse = true)
+        { return getBinding(BindingName(name), forUse); }
+    template <unsigned N>
+    BindId getBindId(const char (&name)[N])
+        { return getBinding(BindingName(name))->getId(); }
+    ///@}
+
+    /// @name Binding values by ID
+    ///@{
+    BindId getBindId(const std::string& name) { return getBinding(name)->getId(); }
+    BindId getBindId(const BindingName& name) { return getBinding(name)->getId(); }
+    float getValue(BindId id) const { return mBindings.values[id]; }
+    bool hasChanged(BindId id) const { return mBindings.hasChanged(id); } //!< Since last 'update()'
+    void getValues(const BindId* ids, unsigned count, float* values) const;
+    void getValues(const std::vector<BindId>& ids, std::vector<float>& values) const
+    {
+        values.resize(ids.size());
+        getValues(ids.data(), ids.size(), values.data());
+    }
+    ///@}
 
     void addKeyListener(OIS::KeyListener*);
     void removeKeyListener(OIS::KeyListener*);
@@ -444,7 +880,7 @@ public:
     OIS::Mouse* getMouse() { return mMouse; }
     float getJoyStickValue(unsigned int) const;
 
-    void _buildBindingListMaps(); //>! Apply change made to bindings
+    void _buildBindingListMaps(); //>! Rebuild every dispatch table, eg. after loading
 
     static std::string convertOISDeviceTypeToString(OIS::Type type);
 
@@ -453,34 +889,187 @@ public:
         Configuration()
         :   mouseSensivityAxisX(0.2f),
             mouseSensivityAxisY(0.2f),
-            mouseSensivityAxisZ(1.0f)
+            mouseSensivityAxisZ(1.0f),
+            mouseCoalesce(false),
+            mouseSmoothing(0.f),
+            joystickBatchAxes(false)
         {}
 
         float mouseSensivityAxisX;
         float mouseSensivityAxisY;
         float mouseSensivityAxisZ;
-        std::vector<float> joystickDeadZones;
+        /// Sum the mouse motion of a capture and dispatch it once per axis,
+        /// mouse listeners still receive every event
+        bool mouseCoalesce;
+        /// Smoothing of the bindings with a mouse axis and no smoothing filter,
+        /// see 'FilterStage::FT_SMOOTH'. Zero to disable.
+        float mouseSmoothing;
+
+        //! Joystick axis noise suppression, in normalized values.
+        //! Joystick listeners still receive every event.
+        struct AxisFilter
+        {
+            AxisFilter(float deadZone = 0.f, float threshold = 0.f)
+            :   deadZone(deadZone), threshold(threshold) {}
+
+            float deadZone; //!< Closer to the center is zero, the rest is rescaled
+            float threshold; //!< Smaller changes aren't dispatched, except to the center and the ends
+
+            bool operator==(const AxisFilter& o) const
+                { return deadZone == o.deadZone && threshold == o.threshold; }
+        };
+
+        struct JoyStickAxisFilter
+        {
+            unsigned joystick;
+            int axis; //!< -1 for every axis of the joystick
+            AxisFilter filter;
+
+            bool operator==(const JoyStickAxisFilter& o) const
+                { return joystick == o.joystick && axis == o.axis && filter == o.filter; }
+        };
+
+        AxisFilter joystickAxisFilter; //!< Default
+        std::vector<JoyStickAxisFilter> joystickAxisFilters; //!< Per joystick or axis
+        /// Axes of every joystick are read after the capture and processed at once,
+        /// only the changed ones are dispatched. See 'AxisBatch'.
+        bool joystickBatchAxes;
+
+        /// Most specific filter of the axis
+        const AxisFilter& getAxisFilter(unsigned joystick, unsigned axis) const
+        {
+            const AxisFilter* filter = &joystickAxisFilter;
+            for (auto& f : joystickAxisFilters)
+            {
+                if (f.joystick != joystick) continue;
+                if (f.axis == (int)axis) return f.filter;
+                if (f.axis < 0) filter = &f.filter;
+            }
+            return *filter;
+        }
+
+        bool operator==(const Configuration& o) const
+        {
+            return mouseSensivityAxisX == o.mouseSensivityAxisX &&
+                   mouseSensivityAxisY == o.mouseSensivityAxisY &&
+                   mouseSensivityAxisZ == o.mouseSensivityAxisZ &&
+                   mouseCoalesce == o.mouseCoalesce &&
+                   mouseSmoothing == o.mouseSmoothing &&
+                   joystickAxisFilter == o.joystickAxisFilter &&
+                   joystickAxisFilters == o.joystickAxisFilters &&
+                   joystickBatchAxes == o.joystickBatchAxes;
+        }
+        bool operator!=(const Configuration& o) const { return !(*this == o); }
     };
 
+    /// Loaded with the bindings, edit it from the dispatching thread
+    Configuration& getConfiguration() { return mConfig; }
+    const Configuration& getConfiguration() const { return mConfig; }
+
 protected:
-    typedef std::deque<Bind*> BindingList;
-    typedef std::unordered_map<InputEvent::Type, BindingList> InputEventBindingListMap;
+    void attachDevices(const DeviceSet& devices);
+    DeviceSet _getDevices() const; //!< Attached devices
+    void _swapDevices(const DeviceSet& devices, bool exclusive);
+    void _createDevicesAsync(bool exclusive);
+    void _pollDevices(); //!< Swap in devices created in the background
+
+    void _enableJoyStickHotplug(unsigned interval);
+    void _pollJoySticks(); //!< Apply the changes of the hotplug scanner
+    unsigned _getJoyStickNumber(const std::string& identity);
+    void _releaseJoyStick(unsigned joystick); //!< Zero every bound component
+    void _layoutAxisBatch();
+    void _dispatchJoyStickAxes(); //!< See 'Configuration::joystickBatchAxes'
 
     void createOIS(bool exclusive = true);
     void destroyOIS();
+    void captureDevices();
+
+    //! Stamp the device event dispatched in its scope, does nothing without 'OISM_ENABLE_LATENCY'
+    struct EventStamp
+    {
+#ifdef OISM_ENABLE_LATENCY
+        EventStamp(Handler* h, LatencyDevice device) : mHandler(h)
+        {
+            h->mEventStamp.time = latency_now();
+            h->mEventStamp.device = device;
+        }
+        ~EventStamp() { mHandler->mEventStamp = LatencyStamp(); }
+        Handler* mHandler;
+#else
+        EventStamp(Handler*, LatencyDevice) {}
+#endif
+    };
+#ifdef OISM_ENABLE_LATENCY
+    void _recordLatency(Bind* b, LatencyType type, const LatencyStamp& stamp);
+#endif
 
-    void setBindingValue(InputEventBindingListMap& bindings, unsigned evt, float value);
+    void setBindingValue(const DispatchTable& table, unsigned slot, float value);
+    void _publishValue(Bind* b, float oldVal);
     void setMouseValue(unsigned cnpt, float value);
+    void setMouseRelative(int x, int y, int z);
+    void _setMouseRelative(float x, float y, float z);
+    void _accumulateMouseRelative(int x, int y, int z); //!< See 'Configuration::mouseCoalesce'
+    void _flushMouseRelative();
     void clearMouseValue();
-    void setKeyboardValue(const OIS::KeyEvent& key, float value);
-    void setJoyStickValue(OIS::ComponentType cpntType, unsigned cpnt, JoyStickListener* lnr, float value);
+    void setKeyboardValue(InputEvent::Type evt, float value);
+    void setJoyStickValue(OIS::ComponentType cpntType, unsigned cpnt, unsigned joystick, float value);
+
+    /// Event added to or removed from a binding
+    struct DispatchEdit
+    {
+        Bind* bind;
+        DispatchTable* table;
+        unsigned slot;
+        InputEvent::Type evt;
+        bool add;
+    };
+    void _editDispatch(Bind* b, DispatchTable& table, unsigned slot, InputEvent::Type evt, bool add);
+    void _applyEdits(const std::vector<DispatchEdit>& edits); //!< Dispatching thread
+
+    /// Events of a binding before and after an edit
+    struct BindingPatch
+    {
+        Bind* bind;
+        Bind::InputEventList oldKeyEvents, oldMouseEvents, oldJoyStickEvents;
+        Bind::InputEventList keyEvents, mouseEvents, joyStickEvents;
+    };
+    /// Copy the events of 'loaded' into the live bindings, bindings missing from
+    /// 'loaded' lose their events. The loaded bindings are deleted.
+    void _mergeBindings(NamedBindingMap& loaded, std::vector<BindingPatch>* patches);
+    void _patchBinding(const BindingPatch& patch); //!< Dispatching thread
+    void _addDispatchEntries(Bind* b, const Bind::InputEventList& keyEvents,
+        const Bind::InputEventList& mouseEvents, const Bind::InputEventList& joyStickEvents);
+
+    typedef std::function<void(NamedBindingMap&, Configuration&)> Loader;
+    struct LoadedFiles
+    {
+        NamedBindingMap bindings;
+        Configuration config;
+    };
+    void _watch(const std::string& path, const std::vector<std::string>& files, const Loader& loader);
+    void _pollReload();
+    void _applyReload(LoadedFiles& loaded);
 
     void _loadBinding(Serializer&);
-    void _saveBinding(Serializer&);
+    void _saveBinding(Serializer&, bool onlyIfChanged = false);
     void _loadConfig(Serializer&);
-    void _saveConfig(Serializer&);
+    void _saveConfig(Serializer&, bool onlyIfChanged = false);
 
     void processInternalCallback();
+    void _updateFilters(); //!< Publish the filtered values, rebuild the chains if needed
+    void _buildFilters();
+
+    //! Compiled sequences of every binding
+    struct SequenceSet
+    {
+        SequenceMatcher matcher;
+        std::vector<Bind*> owners; //!< Owner index of the matcher
+    };
+    void _compileSequences();
+    void _installSequences(const std::shared_ptr<SequenceSet>& sequences); //!< Dispatching thread
+    void _attachSequences(); //!< Add the missing sources of the sequence owners
+    void _advanceSequences(Bind* b, unsigned callbackType);
+    unsigned long long _getEventTime() const { return mEventTimeSet ? mEventTime : recorder_now(); }
     void _setExclusive(bool exclusive); //!< Internal callback
 
     /// @name OIS::MouseListener
@@ -501,30 +1090,105 @@ protected:
     //@{
     void buttonPressed(unsigned button, JoyStickListener* lnr);
     void buttonReleased(unsigned button, JoyStickListener* lnr);
-    void axisMoved(unsigned axis, float value, JoyStickListener* lnr);
+    void axisMoved(unsigned axis, int value, JoyStickListener* lnr);
     void povMoved(unsigned idx, unsigned direction, JoyStickListener* lnr);
     //@}
 
-    InputEventBindingListMap mKeyEvents;
-    InputEventBindingListMap mMouseEvents;
-    InputEventBindingListMap mJoyStickEvents;
+    DispatchTable mKeyEvents;
+    DispatchTable mMouseEvents;
+    DispatchTable mJoyStickEvents;
     NamedBindingMap mBindings;
+    std::shared_ptr<CallbackRegistry> mCallbackRegistry;
 
-    OIS::InputManager* mOIS;
+    std::shared_ptr<DeviceBackend> mBackend; //!< Null without devices
+    OIS::InputManager* mOIS; //!< Null if the backend doesn't use OIS
     OIS::Mouse* mMouse;
     OIS::Keyboard* mKeyboard;
-    std::vector<std::pair<OIS::JoyStick*, JoyStickListener*>> mJoySticks;
+    std::vector<std::pair<OIS::JoyStick*, JoyStickListener*>> mJoySticks; //!< By number, null if disconnected
     std::unordered_set<OIS::KeyListener*> mKeyListeners;
     std::unordered_set<OIS::MouseListener*> mMouseListeners;
 
     Configuration mConfig;
+    unsigned mFilterRevision; //!< Binding revision of the filter chains
+    float mFilterSmoothing; //!< 'Configuration::mouseSmoothing' of the filter chains
+    unsigned mSequenceRevision; //!< Binding revision of the compiled sequences
+    std::shared_ptr<SequenceSet> mSequences; //!< Dispatching thread, null without sequences
+    std::vector<unsigned> mCompletedSequences; //!< Owners being published, see '_advanceSequences()'
+
+    /// Time of the events of a capture or replayed frame for the sequence windows,
+    /// see 'recorder_now()'. Injected events are timed on dispatch.
+    unsigned long long mEventTime;
+    bool mEventTimeSet;
+
+    // Last loaded or saved state, for 'save(path, true)'
+    std::string mSavedBindingPath;
+    unsigned mSavedBindingRevision;
+    std::string mSavedConfigPath;
+    Configuration mSavedConfig;
 
     unsigned long mWindowID;
-    bool mIsExclusive;
+    bool mIsExclusive; //!< Last requested mode
+
+    // Exclusive mode switch, see 'setExclusiveToggle()'
+    ExclusiveToggle mExclusiveToggle;
+    bool mAsyncDeviceCreation;
+    bool mDevicesExclusive; //!< Mode of the attached devices
+    bool mCreatedExclusive; //!< Mode the attached devices were created in
+    bool mCreatingExclusive; //!< Mode of the devices being created
+    bool mRequestedExclusive;
+    std::future<DeviceSet> mPendingDevices;
+    std::future<void> mRetiredDevices; //!< Previous devices being destroyed
+    std::atomic<bool> mExclusivePending;
+
+    // Joystick hotplug, joysticks are created by the scanner instead of with the devices
+    std::unique_ptr<JoyStickHotplug> mHotplug;
+    std::vector<OIS::JoyStick*> mStaleJoySticks; //!< Created with the devices, destroyed with them
+    std::unordered_map<std::string, unsigned> mJoyStickNumbers; //!< By identity
+
+    // Joystick axes batch, laid out again when the joysticks or filters change
+    AxisBatch mAxisBatch;
+    std::vector<OIS::JoyStick*> mAxisBatchJoySticks;
+    Configuration::AxisFilter mAxisBatchFilter;
+    std::vector<Configuration::JoyStickAxisFilter> mAxisBatchFilters;
+
+    std::shared_ptr<Recorder> mRecorder; //!< Dispatching thread, see 'startRecording()'
     std::queue<std::function<void()>> mInternalCallbacks;
+    std::mutex mInternalCallbacksMutex; //!< Pushed by the game thread, run by the dispatching thread
+
+    std::unique_ptr<InputThread> mThread;
+
+    unsigned mBatchDepth; //!< Nested 'BatchEdit'
+    std::vector<DispatchEdit> mBatchEdits;
+
+    // Hot reload
+    std::unique_ptr<FileWatcher> mWatcher;
+    std::string mWatchPath;
+    Loader mLoader;
+    std::future<std::unique_ptr<LoadedFiles>> mReload; //!< Parsing in progress
+    bool mReloadPending; //!< Changed since the last parse started
 
     bool mMouseRelativeUpdatedX, mMouseRelativeUpdatedY, mMouseRelativeUpdatedZ;
     float mMouseLastRelativeX, mMouseLastRelativeY, mMouseLastRelativeZ;
+    float mMouseAccumX, mMouseAccumY, mMouseAccumZ; //!< Scaled motion of the capture
+    bool mMouseAccumulated;
+
+#ifdef OISM_ENABLE_LATENCY
+    LatencyStamp mEventStamp; //!< Dispatching thread
+    LatencyHistogram mLatency[LD_COUNT][LT_COUNT];
+#endif
+};
+
+
+//! Bindings edited during the lifetime of a BatchEdit are applied and published
+//! at once when the outermost one ends, eg. a rebinding menu being closed.
+class BatchEdit : NonCopyable
+{
+public:
+    BatchEdit(Handler* h) : mHandler(h) { ++mHandler->mBatchDepth; }
+    ~BatchEdit();
+
+private:
+    Handler* mHandler;
 };
 
 
@@ -539,7 +1203,7 @@ public:
     void remove(const std::string& name)
         {mCallbacks.erase(name);}
 
-    std::unordered_map<std::string,Bind::CallbackSharedPtr> mCallbacks;
+    std::unordered_map<std::string,CallbackHandle> mCallbacks;
     Handler* mHandler;
 };
 
@@ -556,6 +1220,11 @@ public:
     virtual void saveBinding(const NamedBindingMap&) = 0;
     virtual void saveConfig(Handler::Configuration*) = 0;
 
+    /// Files read by the serializer, watched by 'Handler::watch()'
+    virtual std::vector<std::string> getFiles() const { return std::vector<std::string>(); }
+
+    const std::string& getPath() const { return mPath; }
+
 protected:
     std::string mPath;
 };
@@ -0,0 +1,127 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMInputThread.h"
+#include "OISMHandler.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+using namespace oism;
+
+
+InputThread::InputThread(Handler* handler, unsigned rate, const Pump& pump, const std::vector<float>& values)
+:   mHandler(handler),
+    mPump(pump),
+    mRate(rate ? rate : 1),
+    mLiveValues(values),
+    mDirty(true),
+    mCallbacks(4096),
+    mRunning(false),
+    mStopped(true)
+{
+}
+
+
+void InputThread::start()
+{
+    if (!mStopped) return;
+    mStopped = false;
+    mRunning.store(true, std::memory_order_release);
+    mThread = std::thread([this](){run();});
+}
+
+
+void InputThread::stop()
+{
+    if (mStopped) return;
+    mRunning.store(false, std::memory_order_release);
+    mThread.join();
+    mStopped = true;
+}
+
+
+void InputThread::setValue(unsigned bind, float value)
+{
+    if (bind >= mLiveValues.size()) mLiveValues.resize(bind + 1, 0.f);
+    mLiveValues[bind] = value;
+    mDirty = true;
+
+#ifdef OISM_ENABLE_LATENCY
+    if (bind >= mLiveStamps.size()) mLiveStamps.resize(bind + 1);
+    if (!mLiveStamps[bind].time) mLiveStamps[bind] = mHandler->mEventStamp;
+#endif
+}
+
+
+void InputThread::pushCallback(unsigned bind, unsigned type)
+{
+    CallbackEvent evt = {bind, type};
+#ifdef OISM_ENABLE_LATENCY
+    evt.stamp = mHandler->mEventStamp;
+#endif
+
+    // Keep ordering if some callbacks are already waiting
+    if (!mPendingCallbacks.empty() || !mCallbacks.push(evt))
+        mPendingCallbacks.push_back(evt);
+}
+
+
+const InputThread::Snapshot* InputThread::acquireValues()
+{
+    return mValues.update() ? &mValues.front() : nullptr;
+}
+
+
+bool InputThread::popCallback(CallbackEvent& evt)
+{
+    if (mCallbacks.pop(evt)) return true;
+
+    // Leftovers of a full queue are only reachable once the thread is joined
+    if (!mStopped || mPendingCallbacks.empty()) return false;
+    evt = mPendingCallbacks.front();
+    mPendingCallbacks.erase(mPendingCallbacks.begin());
+    return true;
+}
+
+
+void InputThread::run()
+{
+    using namespace std::chrono;
+
+    const nanoseconds period(1000000000 / mRate);
+    auto next = steady_clock::now();
+
+    while (mRunning.load(std::memory_order_acquire))
+    {
+        mPump();
+        mHandler->processInternalCallback();
+        publish();
+
+        next += period;
+        auto now = steady_clock::now();
+        if (next < now) next = now; // Don't try to catch up
+        else std::this_thread::sleep_until(next);
+    }
+
+    // Last events before the thread stopped
+    publish();
+}
+
+
+void InputThread::publish()
+{
+    unsigned sent = 0;
+    while (sent < mPendingCallbacks.size() && mCallbacks.push(mPendingCallbacks[sent])) ++sent;
+    mPendingCallbacks.erase(mPendingCallbacks.begin(), mPendingCallbacks.begin() + sent);
+
+    if (!mDirty) return;
+    mValues.back().values = mLiveValues;
+#ifdef OISM_ENABLE_LATENCY
+    mValues.back().stamps = mLiveStamps;
+    std::fill(mLiveStamps.begin(), mLiveStamps.end(), LatencyStamp());
+#endif
+    mValues.publish();
+    mDirty = false;
+}
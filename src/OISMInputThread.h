@@ -0,0 +1,92 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include "OISMfwdcl.h"
+#include "OISMLatency.h"
+#include "OISMLockFree.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+namespace oism
+{
+
+
+//! Dedicated thread capturing devices and dispatching events at a fixed rate.
+//! Binding values are published through a triple buffer and callbacks through
+//! a queue, both consumed by 'Handler::update()' on the game thread.
+class InputThread
+{
+public:
+    typedef std::function<void()> Pump;
+
+    struct CallbackEvent
+    {
+        unsigned bind; //!< Binding ID
+        unsigned type; //!< Bind::CallbackType
+#ifdef OISM_ENABLE_LATENCY
+        LatencyStamp stamp;
+#endif
+    };
+
+    //! Binding values published at once
+    struct Snapshot
+    {
+        std::vector<float> values;
+#ifdef OISM_ENABLE_LATENCY
+        std::vector<LatencyStamp> stamps; //!< Oldest event changing each value since the last snapshot
+#endif
+    };
+
+    InputThread(Handler* handler, unsigned rate, const Pump& pump, const std::vector<float>& values);
+    ~InputThread() { stop(); }
+
+    void start();
+    void stop(); //!< Stop and join the thread, remaining events can still be consumed
+
+    /// @name Input thread
+    ///@{
+    void setValue(unsigned bind, float value);
+    void pushCallback(unsigned bind, unsigned type);
+    ///@}
+
+    /// @name Game thread
+    ///@{
+    /// Return the latest binding values, or null if nothing was published since the last call
+    const Snapshot* acquireValues();
+    bool popCallback(CallbackEvent& evt);
+    ///@}
+
+private:
+    InputThread(const InputThread&);
+    InputThread& operator=(const InputThread&);
+
+    void run();
+    void publish();
+
+    Handler* mHandler;
+    Pump mPump;
+    unsigned mRate; //!< Hz
+
+    std::vector<float> mLiveValues;
+#ifdef OISM_ENABLE_LATENCY
+    std::vector<LatencyStamp> mLiveStamps;
+#endif
+    std::vector<CallbackEvent> mPendingCallbacks; //!< Queue was full
+    bool mDirty;
+
+    TripleBuffer<Snapshot> mValues;
+    SpscQueue<CallbackEvent> mCallbacks;
+
+    std::atomic<bool> mRunning;
+    bool mStopped; //!< Thread joined
+    std::thread mThread;
+};
+
+
+} // namespace oism
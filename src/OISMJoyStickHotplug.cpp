@@ -0,0 +1,148 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMJoyStickHotplug.h"
+#include "OISMHandler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+
+
+using namespace oism;
+
+
+JoyStickHotplug::JoyStickHotplug(const std::shared_ptr<DeviceBackend>& backend, unsigned long windowID, unsigned interval)
+:   mBackend(backend),
+    mWindowID(windowID),
+    mInterval(interval ? interval : 1),
+    mScans(16),
+    mRetired(64),
+    mRunning(false)
+{
+}
+
+
+JoyStickHotplug::~JoyStickHotplug()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning = false;
+    }
+    mWake.notify_one();
+    if (mThread.joinable()) mThread.join();
+
+    Scan* scan;
+    while (mScans.pop(scan)) destroyScan(scan);
+    OIS::JoyStick* joystick;
+    while (mRetired.pop(joystick)) mBackend->destroyJoyStick(joystick);
+}
+
+
+void JoyStickHotplug::start()
+{
+    if (mThread.joinable()) return;
+    mRunning = true;
+    mThread = std::thread([this](){run();});
+}
+
+
+JoyStickHotplug::Scan* JoyStickHotplug::pop()
+{
+    Scan* scan;
+    return mScans.pop(scan) ? scan : nullptr;
+}
+
+
+void JoyStickHotplug::retire(OIS::JoyStick* joystick)
+{
+    // Leaked if the queue is full, the scanner is stuck
+    if (!mRetired.push(joystick))
+        log::log(log::Level::Error, "JoyStickHotplug: Retired queue full");
+}
+
+
+void JoyStickHotplug::destroyScan(Scan* scan)
+{
+    for (auto& dev : scan->added) mBackend->destroyJoyStick(dev.joystick);
+    delete scan;
+}
+
+
+void JoyStickHotplug::run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mRunning)
+    {
+        lock.unlock();
+
+        OIS::JoyStick* retired;
+        while (mRetired.pop(retired)) mBackend->destroyJoyStick(retired);
+
+        // An exception must not escape the thread
+        try
+        {
+            scan();
+        }
+        catch (...)
+        {
+            log::log(log::Level::Error, "JoyStickHotplug: Scan failed");
+        }
+
+        lock.lock();
+        mWake.wait_for(lock, std::chrono::milliseconds(mInterval), [this](){return !mRunning;});
+    }
+}
+
+
+void JoyStickHotplug::scan()
+{
+    std::vector<std::string> identities;
+    if (!mBackend->listJoySticks(mWindowID, identities)) return;
+    std::sort(identities.begin(), identities.end());
+    if (identities == mLastIdentities) return;
+
+    // Joysticks are kept while the count of their vendor is unchanged
+    auto vendorCounts = [](const std::vector<std::string>& list)
+    {
+        std::unordered_map<std::string, unsigned> counts;
+        for (auto& identity : list) counts[identity.substr(0, identity.rfind('#'))]++;
+        return counts;
+    };
+    std::unordered_map<std::string, unsigned> before = vendorCounts(mLastIdentities);
+    std::unordered_map<std::string, unsigned> after = vendorCounts(identities);
+
+    std::unique_ptr<Scan> scan(new Scan);
+    std::vector<std::string> kept;
+    for (auto& identity : mLastIdentities)
+    {
+        std::string vendor = identity.substr(0, identity.rfind('#'));
+        if (before[vendor] == after[vendor]) kept.push_back(identity);
+        else scan->removed.push_back(identity);
+    }
+
+    std::vector<std::string> added;
+    for (auto& identity : identities)
+        if (std::find(kept.begin(), kept.end(), identity) == kept.end()) added.push_back(identity);
+
+    // Those failing are tried again on the next scan
+    std::vector<OIS::JoyStick*> joySticks;
+    if (!added.empty()) joySticks = mBackend->createJoySticks(mWindowID, added);
+    for (unsigned i = 0; i < joySticks.size(); i++)
+    {
+        if (!joySticks[i]) continue;
+        scan->added.push_back({added[i], joySticks[i]});
+        kept.push_back(added[i]);
+    }
+    std::sort(kept.begin(), kept.end());
+    if (scan->removed.empty() && scan->added.empty()) return;
+
+    if (!mScans.push(scan.get()))
+    {
+        destroyScan(scan.release());
+        return; // Retried on the next scan
+    }
+    scan.release();
+    mLastIdentities.swap(kept);
+}
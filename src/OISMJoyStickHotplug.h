@@ -0,0 +1,85 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include "OISMLockFree.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace OIS
+{
+    class JoyStick;
+} // namespace OIS
+
+
+namespace oism
+{
+
+
+class DeviceBackend;
+
+
+//! Background joystick enumeration, through 'DeviceBackend::listJoySticks()'.
+//! Keyboard and mouse are never touched. When the connected joysticks change,
+//! only the joysticks of the changed identities are created or retired, and
+//! the change is handed to the dispatching thread through a queue. The count
+//! of a vendor changing changes the identities of all its joysticks, they are
+//! all created again.
+class JoyStickHotplug
+{
+public:
+    struct Device
+    {
+        std::string identity; //!< See 'DeviceBackend::listJoySticks()'
+        OIS::JoyStick* joystick;
+    };
+
+    struct Scan
+    {
+        std::vector<std::string> removed; //!< Retire their joystick
+        std::vector<Device> added; //!< After removal
+    };
+
+    JoyStickHotplug(const std::shared_ptr<DeviceBackend>& backend, unsigned long windowID, unsigned interval);
+    ~JoyStickHotplug(); //!< Stop and destroy every joystick not in use
+
+    void start();
+
+    /// @name Dispatching thread
+    ///@{
+    Scan* pop(); //!< Oldest change, to apply and delete in order, null if none
+    void retire(OIS::JoyStick* joystick); //!< No longer used, destroyed by the scanner
+    ///@}
+
+private:
+    JoyStickHotplug(const JoyStickHotplug&);
+    JoyStickHotplug& operator=(const JoyStickHotplug&);
+
+    void run();
+    void scan();
+    void destroyScan(Scan* scan);
+
+    std::shared_ptr<DeviceBackend> mBackend;
+    unsigned long mWindowID;
+    unsigned mInterval; //!< Milliseconds
+
+    std::vector<std::string> mLastIdentities; //!< Created joysticks, as handed
+    SpscQueue<Scan*> mScans; //!< To the dispatching thread
+    SpscQueue<OIS::JoyStick*> mRetired; //!< From the dispatching thread
+
+    bool mRunning;
+    std::mutex mMutex; //!< Guard 'mRunning'
+    std::condition_variable mWake;
+    std::thread mThread;
+};
+
+
+} // namespace oism
@@ -0,0 +1,54 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMLatency.h"
+
+#include <cmath>
+
+
+using namespace oism;
+
+
+void LatencyHistogram::reset()
+{
+    for (auto& count : mCounts) count.store(0, std::memory_order_relaxed);
+    mCount.store(0, std::memory_order_relaxed);
+    mTotal.store(0, std::memory_order_relaxed);
+    mMax.store(0, std::memory_order_relaxed);
+}
+
+
+double LatencyHistogram::getMean() const
+{
+    unsigned long long count = getCount();
+    return count ? mTotal.load(std::memory_order_relaxed) / (double)count : 0.;
+}
+
+
+unsigned long long LatencyHistogram::getPercentile(double p) const
+{
+    // Buckets may be recorded meanwhile, the sum is used instead of 'mCount'
+    unsigned long long total = 0;
+    for (auto& count : mCounts) total += count.load(std::memory_order_relaxed);
+    if (!total) return 0;
+
+    unsigned long long rank = (unsigned long long)std::ceil(p * total);
+    if (rank < 1) rank = 1;
+
+    unsigned long long seen = 0;
+    for (unsigned i = 0; i < BucketCount; i++)
+    {
+        seen += mCounts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return upperBound(i);
+    }
+    return getMax();
+}
+
+
+unsigned long long LatencyHistogram::upperBound(unsigned index)
+{
+    if (index < SubBuckets) return index;
+    unsigned shift = index / SubBuckets - 1;
+    unsigned long long lower = (unsigned long long)(SubBuckets + index % SubBuckets) << shift;
+    return lower + ((1ull << shift) - 1);
+}
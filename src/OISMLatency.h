@@ -0,0 +1,108 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+
+namespace oism
+{
+
+
+/// @name Input latency
+/// Measured from the event reaching the handler, only with 'OISM_ENABLE_LATENCY'.
+///@{
+enum LatencyDevice
+{
+    LD_KEYBOARD,
+    LD_MOUSE,
+    LD_JOYSTICK,
+    LD_COUNT
+};
+
+enum LatencyType
+{
+    LT_VALUE, //!< Until the value is visible through 'getValue()'
+    LT_CALLBACK, //!< Until the callback is called
+    LT_COUNT
+};
+
+//! Arrival of the event being dispatched
+struct LatencyStamp
+{
+    LatencyStamp() : time(0), device(0) {}
+
+    unsigned long long time; //!< Zero if not a device event
+    unsigned device; //!< LatencyDevice
+};
+
+/// Monotonic nanoseconds, zero is never returned
+inline unsigned long long latency_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count() | 1;
+}
+///@}
+
+
+//! Log-linear histogram of durations in nanoseconds, safe to record and read concurrently.
+//! Values are exact below 'SubBuckets', then within 1/'SubBuckets' of the true value.
+class LatencyHistogram
+{
+public:
+    static const unsigned SubBucketBits = 3;
+    static const unsigned SubBuckets = 1 << SubBucketBits;
+    static const unsigned BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    void record(unsigned long long ns)
+    {
+        mCounts[index(ns)].fetch_add(1, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        mTotal.fetch_add(ns, std::memory_order_relaxed);
+        unsigned long long max = mMax.load(std::memory_order_relaxed);
+        while (ns > max && !mMax.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+    }
+
+    void reset();
+
+    unsigned long long getCount() const { return mCount.load(std::memory_order_relaxed); }
+    unsigned long long getMax() const { return mMax.load(std::memory_order_relaxed); }
+    double getMean() const;
+    /// Upper bound of the bucket holding the 'p' quantile, eg. 0.99
+    unsigned long long getPercentile(double p) const;
+
+    static unsigned index(unsigned long long ns)
+    {
+        if (ns < SubBuckets) return (unsigned)ns;
+        unsigned shift = msb(ns) - SubBucketBits;
+        return (shift + 1) * SubBuckets + (unsigned)((ns >> shift) & (SubBuckets - 1));
+    }
+    static unsigned long long upperBound(unsigned index);
+
+private:
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    static unsigned msb(unsigned long long v)
+    {
+#if defined __GNUC__
+        return 63 - __builtin_clzll(v);
+#else
+        unsigned n = 0;
+        while (v >>= 1) ++n;
+        return n;
+#endif
+    }
+
+    std::atomic<unsigned> mCounts[BucketCount];
+    std::atomic<unsigned long long> mCount;
+    std::atomic<unsigned long long> mTotal;
+    std::atomic<unsigned long long> mMax;
+};
+
+
+} // namespace oism
@@ -0,0 +1,183 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+namespace oism
+{
+
+
+//! Single producer, single consumer triple buffer.
+//! The producer writes into 'back()' and publishes it, the consumer picks up
+//! the latest published buffer with 'update()'. Neither side ever blocks,
+//! intermediate buffers are dropped if the consumer is slower.
+template <class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : mMiddle(1), mBack(0), mFront(2) {}
+
+    /// @name Producer
+    ///@{
+    T& back() { return mBuffers[mBack]; }
+    void publish()
+    {
+        mBack = mMiddle.exchange(mBack | FreshFlag, std::memory_order_acq_rel) & IndexMask;
+    }
+    ///@}
+
+    /// @name Consumer
+    ///@{
+    /// Return true if a new buffer was published since the last call
+    bool update()
+    {
+        if (!(mMiddle.load(std::memory_order_relaxed) & FreshFlag)) return false;
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+    const T& front() const { return mBuffers[mFront]; }
+    ///@}
+
+private:
+    static const unsigned IndexMask = 3;
+    static const unsigned FreshFlag = 4;
+
+    T mBuffers[3];
+    std::atomic<unsigned> mMiddle; //!< Index of the shared buffer and fresh flag
+    unsigned mBack;
+    unsigned mFront;
+};
+
+
+//! Bounded single producer, single consumer queue.
+template <class T>
+class SpscQueue
+{
+public:
+    /// Capacity is rounded up to a power of two
+    explicit SpscQueue(unsigned capacity)
+    :   mHead(0), mTail(0)
+    {
+        unsigned size = 2;
+        while (size < capacity) size <<= 1;
+        mRing.resize(size);
+        mMask = size - 1;
+    }
+
+    /// Producer, return false if the queue is full
+    bool push(const T& t)
+    {
+        unsigned tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) > mMask) return false;
+        mRing[tail & mMask] = t;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer, return false if the queue is empty
+    bool pop(T& t)
+    {
+        unsigned head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) return false;
+        t = mRing[head & mMask];
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+
+    // Padding keep both indices on separate cache lines,
+    // 'alignas' isn't honored by 'new' before C++17
+    std::vector<T> mRing;
+    unsigned mMask;
+    char mPad0[64];
+    std::atomic<unsigned> mHead; //!< Written by the consumer
+    char mPad1[64];
+    std::atomic<unsigned> mTail; //!< Written by the producer
+    char mPad2[64];
+};
+
+
+//! Bounded multiple producers, single consumer queue.
+//! Each cell carries a sequence number telling whose turn it is, producers
+//! claim a cell with a compare and swap and never wait on each other.
+template <class T>
+class MpscQueue
+{
+public:
+    /// Capacity is rounded up to a power of two
+    explicit MpscQueue(unsigned capacity)
+    :   mHead(0), mTail(0)
+    {
+        unsigned size = 2;
+        while (size < capacity) size <<= 1;
+        mCells.reset(new Cell[size]);
+        for (unsigned i = 0; i < size; i++) mCells[i].sequence.store(i, std::memory_order_relaxed);
+        mMask = size - 1;
+    }
+
+    /// Any thread, return false if the queue is full
+    bool push(const T& t)
+    {
+        unsigned tail = mTail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = mCells[tail & mMask];
+            int diff = (int)(cell.sequence.load(std::memory_order_acquire) - tail);
+            if (diff < 0) return false;
+            if (diff == 0)
+            {
+                if (mTail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    cell.data = t;
+                    cell.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else
+            {
+                tail = mTail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Consumer, return false if the queue is empty or the next cell isn't written yet
+    bool pop(T& t)
+    {
+        unsigned head = mHead.load(std::memory_order_relaxed);
+        Cell& cell = mCells[head & mMask];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        t = cell.data;
+        cell.sequence.store(head + mMask + 1, std::memory_order_release);
+        mHead.store(head + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    MpscQueue(const MpscQueue&);
+    MpscQueue& operator=(const MpscQueue&);
+
+    struct Cell
+    {
+        std::atomic<unsigned> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> mCells;
+    unsigned mMask;
+    char mPad0[64];
+    std::atomic<unsigned> mHead; //!< Written by the consumer
+    char mPad1[64];
+    std::atomic<unsigned> mTail; //!< Written by the producers
+    char mPad2[64];
+};
+
+
+} // namespace oism
@@ -0,0 +1,186 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMLog.h"
+#include "OISMLockFree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+using namespace oism;
+
+
+// Globals
+log::Func_t oism::log::g_Func;
+std::atomic<int> oism::log::g_MinLevel(0);
+std::atomic<bool> oism::log::g_Async(false);
+
+
+namespace
+{
+
+    //! Background thread draining the ring
+    struct AsyncSink
+    {
+        AsyncSink() : running(false), dropped(0) {}
+        ~AsyncSink() { stop(); }
+
+        void start(unsigned capacity)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (running) return;
+            if (!ring) ring.reset(new MpscQueue<log::Record>(capacity));
+            running = true;
+            thread = std::thread([this](){run();});
+            log::g_Async.store(true, std::memory_order_release);
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!running) return;
+                running = false;
+                log::g_Async.store(false, std::memory_order_release);
+            }
+            wake.notify_one();
+            thread.join();
+            drain();
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (running)
+            {
+                lock.unlock();
+                drain();
+                lock.lock();
+                wake.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+
+        void drain()
+        {
+            log::Record r;
+            while (ring->pop(r))
+                if (log::g_Func) log::g_Func(std::string(r.text, r.length), r.level);
+
+            if (unsigned n = dropped.exchange(0, std::memory_order_relaxed))
+                if (log::g_Func) log::g_Func("Log: "+std::to_string(n)+" messages dropped, ring full", log::Level::Warning);
+        }
+
+        std::unique_ptr<MpscQueue<log::Record>> ring; //!< Kept once created, producers may still hold it
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool running;
+        std::atomic<unsigned> dropped;
+        std::thread thread;
+    };
+
+    AsyncSink g_sink;
+
+} // namespace
+
+
+/*
+=====================
+log
+=====================
+*/
+
+
+void log::startAsync(unsigned capacity/* = 1024*/)
+{
+    g_sink.start(capacity);
+}
+
+
+void log::stopAsync()
+{
+    g_sink.stop();
+}
+
+
+bool log::isAsync()
+{
+    return g_Async.load(std::memory_order_relaxed);
+}
+
+
+void log::write(const Record& r)
+{
+    if (g_Async.load(std::memory_order_acquire))
+    {
+        if (!g_sink.ring->push(r)) g_sink.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (g_Func)
+    {
+        g_Func(std::string(r.text, r.length), r.level);
+    }
+}
+
+
+void log::write(const std::string& msg, Level lvl)
+{
+    if (!g_Async.load(std::memory_order_acquire))
+    {
+        if (g_Func) g_Func(msg, lvl);
+        return;
+    }
+
+    // Started meanwhile
+    Record r;
+    r.level = lvl;
+    r.length = 0;
+    append(r, msg);
+    write(r);
+}
+
+
+/*
+=====================
+log::Number
+=====================
+*/
+
+
+log::Number::Number(unsigned long long v)
+:   length(0)
+{
+    char digits[20];
+    do
+    {
+        digits[length++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    std::reverse_copy(digits, digits + length, text);
+}
+
+
+log::Number::Number(long long v)
+:   length(0)
+{
+    if (v >= 0)
+    {
+        *this = Number((unsigned long long)v);
+        return;
+    }
+    *this = Number(0ull - (unsigned long long)v);
+    std::memmove(text + 1, text, length++);
+    text[0] = '-';
+}
+
+
+log::Number::Number(double v)
+:   length(0)
+{
+    int n = std::snprintf(text, sizeof(text), "%g", v);
+    if (n > 0) length = std::min<unsigned>(n, sizeof(text) - 1);
+}
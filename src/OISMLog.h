@@ -0,0 +1,159 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <string>
+
+
+namespace oism
+{
+
+
+namespace log
+{
+
+    enum class Level
+    {
+        Info,
+        Warning,
+        Error
+    };
+
+    typedef std::function<void(const std::string&, Level)> Func_t;
+    extern Func_t g_Func;
+    extern std::atomic<int> g_MinLevel;
+    extern std::atomic<bool> g_Async; //!< See 'startAsync()'
+
+    /// Set logger
+    inline void set(const Func_t& func) { g_Func = func; }
+
+    /// Messages below 'lvl' are discarded before being formatted
+    inline void setMinLevel(Level lvl) { g_MinLevel.store((int)lvl, std::memory_order_relaxed); }
+    inline Level getMinLevel() { return (Level)g_MinLevel.load(std::memory_order_relaxed); }
+
+    /// @name Asynchronous sink
+    /// Messages are copied into a fixed size ring and passed to the logger by a
+    /// background thread, logging then never allocate nor block. Messages are
+    /// truncated to 'Record::TextSize' and dropped when the ring is full.
+    /// The ring keeps the capacity of the first start.
+    ///@{
+    void startAsync(unsigned capacity = 1024);
+    void stopAsync(); //!< Pass the remaining messages and join the thread
+    bool isAsync();
+    ///@}
+
+    //! Formatted message of the asynchronous sink, longer ones are truncated
+    struct Record
+    {
+        static const unsigned TextSize = 248;
+
+        Level level;
+        unsigned length;
+        char text[TextSize];
+    };
+
+    //! Digits of a number
+    struct Number
+    {
+        Number(long long v);
+        Number(unsigned long long v);
+        Number(double v);
+
+        unsigned length;
+        char text[32];
+    };
+
+    /// @name Formatting
+    /// Arguments are appended to a string, or to a record without allocating.
+    ///@{
+    inline void append(std::string& out, const char* s, size_t size) { out.append(s, size); }
+    inline void append(Record& r, const char* s, size_t size)
+    {
+        size_t n = std::min<size_t>(size, Record::TextSize - r.length);
+        std::memcpy(r.text + r.length, s, n);
+        r.length += n;
+    }
+    template <class Out> inline void append(Out& out, const char* s) { append(out, s, std::strlen(s)); }
+    template <class Out> inline void append(Out& out, const std::string& s) { append(out, s.data(), s.size()); }
+    template <class Out> inline void append(Out& out, char c) { append(out, &c, 1); }
+    template <class Out> inline void append(Out& out, const Number& n) { append(out, n.text, n.length); }
+    template <class Out> inline void append(Out& out, long long v) { append(out, Number(v)); }
+    template <class Out> inline void append(Out& out, unsigned long long v) { append(out, Number(v)); }
+    template <class Out> inline void append(Out& out, int v) { append(out, Number((long long)v)); }
+    template <class Out> inline void append(Out& out, long v) { append(out, Number((long long)v)); }
+    template <class Out> inline void append(Out& out, unsigned v) { append(out, Number((unsigned long long)v)); }
+    template <class Out> inline void append(Out& out, unsigned long v) { append(out, Number((unsigned long long)v)); }
+    template <class Out> inline void append(Out& out, double v) { append(out, Number(v)); }
+
+    template <class Out> inline void format(Out&) {}
+    template <class Out, class T, class... Args>
+    inline void format(Out& out, const T& t, const Args&... args)
+    {
+        append(out, t);
+        format(out, args...);
+    }
+    ///@}
+
+    /// @name Sink
+    /// Pass a formatted message to the asynchronous sink or to the logger
+    ///@{
+    void write(const Record& r);
+    void write(const std::string& msg, Level lvl);
+    ///@}
+
+#ifdef OISM_ENABLE_LOG
+    inline bool enabled(Level lvl)
+    {
+        return (int)lvl >= g_MinLevel.load(std::memory_order_relaxed) &&
+            (g_Async.load(std::memory_order_relaxed) || g_Func);
+    }
+
+    /// Arguments are only formatted if the level is enabled, eg.
+    /// log(Level::Warning, "Joystick ", id, " disconnected")
+    template <class... Args>
+    inline void log(Level lvl, const Args&... args)
+    {
+        if (!enabled(lvl)) return;
+        if (!g_Async.load(std::memory_order_acquire))
+        {
+            std::string msg;
+            format(msg, args...);
+            write(msg, lvl);
+            return;
+        }
+        Record r;
+        r.level = lvl;
+        r.length = 0;
+        format(r, args...);
+        write(r);
+    }
+
+    /// Safe to use on empty function + default parameter
+    inline void log(const std::string& msg, Level lvl = Level::Info) { log(lvl, msg); }
+#else // OISM_ENABLE_LOG
+    inline bool enabled(Level lvl) { return false; }
+    template <class... Args>
+    inline void log(Level lvl, const Args&... args) {}
+    inline void log(const std::string& msg, Level lvl = Level::Info) {}
+#endif // OISM_ENABLE_LOG
+
+    inline std::string to_string(Level lvl)
+    {
+        switch (lvl)
+        {
+            case Level::Info: return "";
+            case Level::Warning: return "WARNING | ";
+            case Level::Error: return "== ERROR == | ";
+        }
+        return "";
+    }
+
+} // namespace log
+
+
+} // namespace oism
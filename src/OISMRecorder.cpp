@@ -0,0 +1,300 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMRecorder.h"
+#include "OISMHandler.h"
+
+#include <cstring>
+
+
+using namespace oism;
+
+
+namespace
+{
+
+const char g_magic[] = "OISMREC1";
+const unsigned g_magicSize = sizeof(g_magic) - 1;
+
+const unsigned g_maxAxes = 64; //!< Per joystick for the axis deltas, higher ones share slots
+
+
+void write_varint(std::string& out, unsigned long long v)
+{
+    while (v >= 0x80)
+    {
+        out += (char)(v | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+
+bool read_varint(const unsigned char*& p, const unsigned char* end, unsigned long long& v)
+{
+    v = 0;
+    for (unsigned shift = 0; p != end && shift < 64; shift += 7)
+    {
+        unsigned char byte = *p++;
+        v |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+
+unsigned zigzag(int v) { return ((unsigned)v << 1) ^ (unsigned)(v >> 31); }
+int unzigzag(unsigned v) { return (int)(v >> 1) ^ -(int)(v & 1); }
+
+
+// Field count of each record type, signed fields are zigzag encoded.
+// Device and component numbers are never negative.
+const unsigned char g_fieldCount[RecordedEvent::RT_COUNT] = {0, 2, 1, 3, 2, 3, 3};
+
+bool is_signed(unsigned type, unsigned field)
+{
+    return type == RecordedEvent::RT_MOUSE_MOVE || (type == RecordedEvent::RT_JOYSTICK_AXIS && field == 2);
+}
+
+
+int& last_axis(std::vector<int>& axes, int joystick, int axis)
+{
+    unsigned i = (unsigned)joystick * g_maxAxes + ((unsigned)axis % g_maxAxes);
+    if (i >= axes.size()) axes.resize(i + 1, 0);
+    return axes[i];
+}
+
+} // namespace
+
+
+/*
+=====================
+Recorder
+=====================
+*/
+
+
+Recorder::Recorder(const std::string& path, unsigned capacity/* = 65536*/)
+:   mFile(std::fopen(path.c_str(), "wb")),
+    mStart(recorder_now()),
+    mTime(mStart),
+    mRing(capacity),
+    mDropped(0),
+    mLastTime(0),
+    mRunning(false)
+{
+    if (!mFile)
+    {
+        log::log(log::Level::Error, "Recorder: Could not open '", path, "'");
+        return;
+    }
+
+    std::fwrite(g_magic, 1, g_magicSize, mFile);
+    mRunning = true;
+    mThread = std::thread([this](){run();});
+}
+
+
+Recorder::~Recorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning = false;
+    }
+    mWake.notify_one();
+    if (mThread.joinable()) mThread.join();
+
+    if (!mFile) return;
+    drain();
+    std::fclose(mFile);
+
+    if (mDropped)
+        log::log(log::Level::Warning, "Recorder: ", mDropped, " events dropped, ring full");
+}
+
+
+void Recorder::run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mRunning)
+    {
+        lock.unlock();
+        drain();
+        lock.lock();
+        mWake.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+
+void Recorder::drain()
+{
+    mBuffer.clear();
+
+    RecordedEvent evt;
+    while (mRing.pop(evt))
+    {
+        mBuffer += (char)(evt.type | (evt.flag << 4));
+        write_varint(mBuffer, evt.time - mLastTime);
+        mLastTime = evt.time;
+
+        if (evt.type == RecordedEvent::RT_JOYSTICK_AXIS)
+        {
+            int& last = last_axis(mLastAxes, evt.a, evt.b);
+            int value = evt.c;
+            evt.c -= last;
+            last = value;
+        }
+
+        const int fields[] = {evt.a, evt.b, evt.c};
+        for (unsigned i = 0; i < g_fieldCount[evt.type]; i++)
+            write_varint(mBuffer, is_signed(evt.type, i) ? zigzag(fields[i]) : (unsigned)fields[i]);
+    }
+
+    if (mBuffer.empty()) return;
+    std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+    std::fflush(mFile);
+}
+
+
+/*
+=====================
+Player
+=====================
+*/
+
+
+Player::Player(const std::string& path)
+:   mPosition(0),
+    mTime(0),
+    mClearMouse(false),
+    mOpen(false)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        log::log(log::Level::Error, "Player: Could not open '", path, "'");
+        return;
+    }
+
+    std::vector<char> data;
+    char chunk[65536];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + read);
+    std::fclose(file);
+
+    mOpen = decode(data.data(), data.size(), mEvents);
+    if (!mOpen) log::log(log::Level::Error, "Player: Invalid recording '", path, "'");
+}
+
+
+Player::Player(const std::vector<RecordedEvent>& events)
+:   mEvents(events),
+    mPosition(0),
+    mTime(0),
+    mClearMouse(false),
+    mOpen(true)
+{
+}
+
+
+bool Player::decode(const char* data, unsigned size, std::vector<RecordedEvent>& events)
+{
+    events.clear();
+    if (size < g_magicSize || std::memcmp(data, g_magic, g_magicSize)) return false;
+
+    const unsigned char* p = (const unsigned char*)data + g_magicSize;
+    const unsigned char* end = (const unsigned char*)data + size;
+
+    std::vector<int> lastAxes;
+    unsigned long long time = 0;
+    while (p != end)
+    {
+        RecordedEvent evt;
+        evt.type = *p & 0xf;
+        evt.flag = *p++ >> 4;
+        if (evt.type >= RecordedEvent::RT_COUNT) return false;
+
+        unsigned long long v;
+        if (!read_varint(p, end, v)) return false;
+        time += v;
+        evt.time = time;
+
+        int fields[] = {0, 0, 0};
+        for (unsigned i = 0; i < g_fieldCount[evt.type]; i++)
+        {
+            if (!read_varint(p, end, v)) return false;
+            fields[i] = is_signed(evt.type, i) ? unzigzag((unsigned)v) : (int)v;
+        }
+        evt.a = fields[0];
+        evt.b = fields[1];
+        evt.c = fields[2];
+
+        if (evt.type == RecordedEvent::RT_JOYSTICK_AXIS)
+        {
+            int& last = last_axis(lastAxes, evt.a, evt.b);
+            evt.c += last;
+            last = evt.c;
+        }
+
+        events.push_back(evt);
+    }
+    return true;
+}
+
+
+bool Player::playFrame(Handler* handler)
+{
+    if (mPosition >= mEvents.size()) return false;
+
+    // Done at the start of the capture following the frame
+    if (mClearMouse) handler->clearMouseValue();
+    mClearMouse = false;
+
+    while (mPosition < mEvents.size())
+    {
+        const RecordedEvent& evt = mEvents[mPosition++];
+        mTime = evt.time;
+        handler->mEventTime = evt.time;
+        handler->mEventTimeSet = true;
+
+        switch (evt.type)
+        {
+            case RecordedEvent::RT_FRAME:
+                handler->_flushMouseRelative();
+                handler->mEventTimeSet = false;
+                mClearMouse = evt.flag;
+                return true;
+            case RecordedEvent::RT_KEY:
+                handler->injectKey(evt.a, evt.b, evt.flag);
+                break;
+            case RecordedEvent::RT_MOUSE_BUTTON:
+                handler->injectMouseButton(evt.a, evt.flag);
+                break;
+            case RecordedEvent::RT_MOUSE_MOVE:
+                // Same path as the recorded device events
+                if (handler->mConfig.mouseCoalesce) handler->_accumulateMouseRelative(evt.a, evt.b, evt.c);
+                else handler->injectMouseMove(evt.a, evt.b, evt.c);
+                break;
+            case RecordedEvent::RT_JOYSTICK_BUTTON:
+                handler->injectJoyStickButton(evt.a, evt.b, evt.flag);
+                break;
+            case RecordedEvent::RT_JOYSTICK_AXIS:
+                handler->injectJoyStickAxis(evt.a, evt.b, evt.c);
+                break;
+            case RecordedEvent::RT_JOYSTICK_POV:
+                handler->injectJoyStickPov(evt.a, evt.b, evt.c);
+                break;
+        }
+    }
+    handler->mEventTimeSet = false;
+    return true;
+}
+
+
+void Player::rewind()
+{
+    mPosition = 0;
+    mTime = 0;
+    mClearMouse = false;
+}
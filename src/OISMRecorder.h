@@ -0,0 +1,160 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include "OISMfwdcl.h"
+#include "OISMLockFree.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace oism
+{
+
+
+/// Steady clock microseconds, time of the device events, see 'Recorder::setTime()'
+inline unsigned long long recorder_now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//! Device event as received by the handler, before dispatch
+struct RecordedEvent
+{
+    enum Type
+    {
+        RT_FRAME, //!< End of a capture, 'flag' set if the mouse was cleared
+        RT_KEY, //!< a: key, b: modifiers
+        RT_MOUSE_BUTTON, //!< a: button
+        RT_MOUSE_MOVE, //!< a, b, c: relative X, Y, Z
+        RT_JOYSTICK_BUTTON, //!< a: joystick, b: button
+        RT_JOYSTICK_AXIS, //!< a: joystick, b: axis, c: raw value
+        RT_JOYSTICK_POV, //!< a: joystick, b: index, c: direction
+        RT_COUNT
+    };
+
+    unsigned long long time; //!< Microseconds since the recording started
+    unsigned char type;
+    unsigned char flag; //!< Pressed
+    int a, b, c;
+};
+
+
+//! Record the device events received by a handler to a file.
+//! Events are pushed to a preallocated ring without allocating or blocking,
+//! a background thread drains it and write the encoded stream. Events are
+//! dropped if the ring is full, the recording is then incomplete. Events are
+//! timed by the handler, the events of a capture share its time.
+//!
+//! Stream: "OISMREC1", then per event a tag byte (type, flag << 4),
+//! the time since the previous event and the fields as varints.
+//! Signed fields are zigzag encoded, axis values are deltas per axis.
+class Recorder
+{
+public:
+    Recorder(const std::string& path, unsigned capacity = 65536);
+    ~Recorder(); //!< Write remaining events and close the file
+
+    bool isOpen() const { return mFile; }
+    unsigned getDropped() const { return mDropped; }
+
+    /// Time of the next events, see 'recorder_now()'
+    void setTime(unsigned long long time) { mTime = time; }
+
+    /// @name Dispatching thread
+    ///@{
+    void frame(bool mouseCleared) { push(RecordedEvent::RT_FRAME, mouseCleared, 0, 0, 0); }
+    void key(unsigned key, unsigned modifiers, bool pressed)
+        { push(RecordedEvent::RT_KEY, pressed, key, modifiers, 0); }
+    void mouseButton(unsigned button, bool pressed)
+        { push(RecordedEvent::RT_MOUSE_BUTTON, pressed, button, 0, 0); }
+    void mouseMove(int relX, int relY, int relZ)
+        { push(RecordedEvent::RT_MOUSE_MOVE, 0, relX, relY, relZ); }
+    void joyStickButton(unsigned joystick, unsigned button, bool pressed)
+        { push(RecordedEvent::RT_JOYSTICK_BUTTON, pressed, joystick, button, 0); }
+    void joyStickAxis(unsigned joystick, unsigned axis, int value)
+        { push(RecordedEvent::RT_JOYSTICK_AXIS, 0, joystick, axis, value); }
+    void joyStickPov(unsigned joystick, unsigned idx, unsigned direction)
+        { push(RecordedEvent::RT_JOYSTICK_POV, 0, joystick, idx, direction); }
+    ///@}
+
+private:
+    Recorder(const Recorder&);
+    Recorder& operator=(const Recorder&);
+
+    void push(unsigned char type, bool flag, int a, int b, int c)
+    {
+        RecordedEvent evt;
+        evt.time = mTime > mStart ? mTime - mStart : 0;
+        evt.type = type;
+        evt.flag = flag;
+        evt.a = a;
+        evt.b = b;
+        evt.c = c;
+        if (!mRing.push(evt)) mDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run();
+    void drain();
+
+    std::FILE* mFile;
+    unsigned long long mStart; //!< See 'recorder_now()'
+    unsigned long long mTime;
+    SpscQueue<RecordedEvent> mRing;
+    std::atomic<unsigned> mDropped;
+
+    // Drain thread
+    std::string mBuffer;
+    unsigned long long mLastTime;
+    std::vector<int> mLastAxes; //!< By joystick and axis
+
+    bool mRunning;
+    std::mutex mMutex; //!< Guard 'mRunning'
+    std::condition_variable mWake;
+    std::thread mThread;
+};
+
+
+//! Replay a recording through the event injection of a handler.
+//! The handler must have the same bindings and configuration as the recorded one,
+//! and no devices attached, see 'Handler()'.
+class Player
+{
+public:
+    Player(const std::string& path); //!< Decode the whole file
+    Player(const std::vector<RecordedEvent>& events);
+
+    bool isOpen() const { return mOpen; }
+    const std::vector<RecordedEvent>& getEvents() const { return mEvents; }
+
+    /// Inject the events of the next captured frame, return false at the end
+    bool playFrame(Handler* handler);
+    void play(Handler* handler) { while (playFrame(handler)) {} }
+    void rewind();
+
+    /// Recording time of the last played event, microseconds
+    unsigned long long getTime() const { return mTime; }
+
+    /// Decode a stream written by 'Recorder', return false if it's invalid
+    static bool decode(const char* data, unsigned size, std::vector<RecordedEvent>& events);
+
+private:
+    std::vector<RecordedEvent> mEvents;
+    unsigned mPosition;
+    unsigned long long mTime;
+    bool mClearMouse;
+    bool mOpen;
+};
+
+
+} // namespace oism
@@ -0,0 +1,217 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMSequence.h"
+
+#include <algorithm>
+
+
+using namespace oism;
+
+
+const unsigned SequenceMatcher::None;
+const unsigned SequenceMatcher::MaxOrders;
+
+
+bool SequenceMatcher::add(unsigned owner, const std::vector<std::vector<unsigned>>& steps, unsigned window)
+{
+    // Every order of the chords, step by step
+    std::vector<std::vector<unsigned>> orders(1);
+    for (auto& step : steps)
+    {
+        std::vector<unsigned> chord(step);
+        std::sort(chord.begin(), chord.end());
+        chord.erase(std::unique(chord.begin(), chord.end()), chord.end());
+        if (chord.empty()) continue;
+
+        std::vector<std::vector<unsigned>> next;
+        do
+        {
+            for (auto& order : orders)
+            {
+                next.push_back(order);
+                next.back().insert(next.back().end(), chord.begin(), chord.end());
+            }
+            if (next.size() > MaxOrders) return false;
+        } while (std::next_permutation(chord.begin(), chord.end()));
+        orders.swap(next);
+    }
+    if (orders[0].empty()) return false;
+
+    unsigned lastStep = orders[0].size();
+    for (auto it = steps.rbegin(); it != steps.rend(); ++it)
+    {
+        if (it->empty()) continue;
+        std::vector<unsigned> chord(*it);
+        std::sort(chord.begin(), chord.end());
+        lastStep = std::unique(chord.begin(), chord.end()) - chord.begin();
+        break;
+    }
+
+    for (auto& order : orders)
+    {
+        Pattern p = {owner, window, (unsigned)mPatternSymbols.size(), (unsigned)order.size(), lastStep};
+        for (auto bind : order)
+        {
+            if (bind >= mSymbols.size()) mSymbols.resize(bind + 1, None);
+            if (mSymbols[bind] == None) mSymbols[bind] = mSymbolCount++;
+            mPatternSymbols.push_back(mSymbols[bind]);
+        }
+        mPatterns.push_back(p);
+        mMaxLength = std::max(mMaxLength, p.length);
+    }
+    return true;
+}
+
+
+void SequenceMatcher::compile()
+{
+    // Trie of the patterns
+    std::vector<std::vector<Edge>> children(1);
+    std::vector<std::vector<unsigned>> outputs(1);
+    for (unsigned i = 0; i < mPatterns.size(); i++)
+    {
+        const Pattern& p = mPatterns[i];
+        unsigned state = 0;
+        for (unsigned s = p.first; s < p.first + p.length; s++)
+        {
+            const unsigned symbol = mPatternSymbols[s];
+            auto it = std::find_if(children[state].begin(), children[state].end(),
+                [symbol](const Edge& e){return e.symbol == symbol;});
+            if (it != children[state].end())
+            {
+                state = it->next;
+                continue;
+            }
+            unsigned next = children.size();
+            children[state].push_back({symbol, next});
+            children.push_back(std::vector<Edge>());
+            outputs.push_back(std::vector<unsigned>());
+            state = next;
+        }
+        outputs[state].push_back(i);
+    }
+
+    mEdgeStart.clear();
+    mEdges.clear();
+    for (auto& edges : children)
+    {
+        std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b){return a.symbol < b.symbol;});
+        mEdgeStart.push_back(mEdges.size());
+        mEdges.insert(mEdges.end(), edges.begin(), edges.end());
+    }
+    mEdgeStart.push_back(mEdges.size());
+
+    mRoot.assign(mSymbolCount, 0);
+    for (unsigned e = mEdgeStart[0]; e < mEdgeStart[1]; e++) mRoot[mEdges[e].symbol] = mEdges[e].next;
+
+    // Failure links, breadth first so the failure state of a state is complete before it
+    mFail.assign(children.size(), 0);
+    std::vector<unsigned> queue;
+    for (unsigned e = mEdgeStart[0]; e < mEdgeStart[1]; e++) queue.push_back(mEdges[e].next);
+    for (unsigned i = 0; i < queue.size(); i++)
+    {
+        unsigned state = queue[i];
+        for (unsigned e = mEdgeStart[state]; e < mEdgeStart[state + 1]; e++)
+        {
+            const Edge& edge = mEdges[e];
+            unsigned fail = mFail[state];
+            unsigned next = None;
+            while (fail && (next = _child(fail, edge.symbol)) == None) fail = mFail[fail];
+            mFail[edge.next] = fail ? next : mRoot[edge.symbol];
+
+            auto& out = outputs[edge.next];
+            out.insert(out.end(), outputs[mFail[edge.next]].begin(), outputs[mFail[edge.next]].end());
+            queue.push_back(edge.next);
+        }
+    }
+
+    mOutputStart.clear();
+    mOutputs.clear();
+    for (auto& out : outputs)
+    {
+        mOutputStart.push_back(mOutputs.size());
+        mOutputs.insert(mOutputs.end(), out.begin(), out.end());
+    }
+    mOutputStart.push_back(mOutputs.size());
+
+    unsigned size = 1;
+    while (size < mMaxLength) size <<= 1;
+    mTimes.assign(size, 0);
+    mPressCount = 0;
+    mState = 0;
+    mActive.clear();
+}
+
+
+const std::vector<unsigned>& SequenceMatcher::press(unsigned bind, unsigned long long time)
+{
+    mCompleted.clear();
+    if (!isSymbol(bind)) return mCompleted;
+
+    const unsigned mask = mTimes.size() - 1;
+    mTimes[mPressCount++ & mask] = time;
+
+    const unsigned symbol = mSymbols[bind];
+    unsigned next = None;
+    while (mState && (next = _child(mState, symbol)) == None) mState = mFail[mState];
+    mState = mState ? next : mRoot[symbol];
+
+    for (unsigned i = mOutputStart[mState]; i < mOutputStart[mState + 1]; i++)
+    {
+        const Pattern& p = mPatterns[mOutputs[i]];
+        if (time - mTimes[(mPressCount - p.length) & mask] > p.window * 1000ull) continue;
+
+        // Held until released, completing it again does nothing
+        auto it = std::find_if(mActive.begin(), mActive.end(),
+            [this, &p](unsigned active){return mPatterns[active].owner == p.owner;});
+        if (it != mActive.end())
+        {
+            *it = mOutputs[i];
+            continue;
+        }
+        mActive.push_back(mOutputs[i]);
+        mCompleted.push_back(p.owner);
+    }
+    return mCompleted;
+}
+
+
+const std::vector<unsigned>& SequenceMatcher::release(unsigned bind)
+{
+    mCompleted.clear();
+    if (!isSymbol(bind)) return mCompleted;
+
+    unsigned symbol = mSymbols[bind];
+    for (unsigned i = 0; i < mActive.size();)
+    {
+        const Pattern& p = mPatterns[mActive[i]];
+        if (!_isInLastStep(p, symbol))
+        {
+            i++;
+            continue;
+        }
+        mCompleted.push_back(p.owner);
+        mActive[i] = mActive.back();
+        mActive.pop_back();
+    }
+    return mCompleted;
+}
+
+
+unsigned SequenceMatcher::_child(unsigned state, unsigned symbol) const
+{
+    auto first = mEdges.begin() + mEdgeStart[state];
+    auto last = mEdges.begin() + mEdgeStart[state + 1];
+    auto it = std::lower_bound(first, last, symbol, [](const Edge& e, unsigned s){return e.symbol < s;});
+    return it != last && it->symbol == symbol ? it->next : None;
+}
+
+
+bool SequenceMatcher::_isInLastStep(const Pattern& p, unsigned symbol) const
+{
+    unsigned end = p.first + p.length;
+    for (unsigned s = end - p.lastStep; s < end; s++)
+        if (mPatternSymbols[s] == symbol) return true;
+    return false;
+}
@@ -0,0 +1,103 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace oism
+{
+
+
+//! Bindings to press in order within a time window, see 'Bind::addSequence()'
+struct BindSequence
+{
+    typedef std::vector<std::string> Step; //!< Binding names, pressed in any order for a chord
+
+    BindSequence() : window(0) {}
+    BindSequence(unsigned window) : window(window) {}
+
+    bool operator==(const BindSequence& o) const { return window == o.window && steps == o.steps; }
+    bool operator!=(const BindSequence& o) const { return !(*this == o); }
+
+    unsigned window; //!< Milliseconds from the first press to the last
+    std::vector<Step> steps;
+};
+
+
+//! Every sequence compiled into one automaton (Aho-Corasick) over the presses
+//! of the bindings they use. States only keep the transitions of their trie
+//! children, sorted by symbol, and a failure link followed when none matches,
+//! so the size grows with the total length of the sequences. Only the root
+//! state has a transition for every symbol. A press follows a few links on
+//! average, then checks the sequences ending there. Chords are expanded to
+//! each order of their presses.
+class SequenceMatcher
+{
+public:
+    static const unsigned None = ~0u;
+    static const unsigned MaxOrders = 1024; //!< Chord orders of a sequence
+
+    SequenceMatcher() : mSymbolCount(0), mMaxLength(0), mState(0), mPressCount(0) {}
+
+    /// Steps are binding IDs, 'owner' is returned when the sequence completes.
+    /// Return false if a chord has too many orders.
+    bool add(unsigned owner, const std::vector<std::vector<unsigned>>& steps, unsigned window);
+    void compile(); //!< After adding, state is reset
+    bool empty() const { return mPatterns.empty(); }
+
+    inline bool isSymbol(unsigned bind) const { return bind < mSymbols.size() && mSymbols[bind] != None; }
+
+    /// @name Advance
+    /// Return the owners of the completed sequences, released when a binding
+    /// of their last step is released. Presses are timed in microseconds.
+    ///@{
+    const std::vector<unsigned>& press(unsigned bind, unsigned long long time);
+    const std::vector<unsigned>& release(unsigned bind);
+    ///@}
+
+    unsigned getStateCount() const { return mFail.size(); }
+    unsigned getTransitionCount() const { return mEdges.size(); }
+
+private:
+    struct Pattern
+    {
+        unsigned owner;
+        unsigned window; //!< Milliseconds
+        unsigned first, length; //!< In 'mPatternSymbols'
+        unsigned lastStep; //!< Length of the last step, at the end of the pattern
+    };
+
+    struct Edge
+    {
+        unsigned symbol;
+        unsigned next;
+    };
+
+    unsigned _child(unsigned state, unsigned symbol) const; //!< 'None' if none
+    bool _isInLastStep(const Pattern& p, unsigned symbol) const;
+
+    std::vector<unsigned> mSymbols; //!< By binding ID
+    unsigned mSymbolCount;
+    std::vector<Pattern> mPatterns;
+    std::vector<unsigned> mPatternSymbols;
+    unsigned mMaxLength;
+
+    std::vector<unsigned> mEdgeStart; //!< One more than the states
+    std::vector<Edge> mEdges; //!< Trie children of each state, sorted by symbol
+    std::vector<unsigned> mFail; //!< Longest suffix state, by state
+    std::vector<unsigned> mRoot; //!< Next state from the root, by symbol
+    std::vector<unsigned> mOutputStart; //!< One more than the states
+    std::vector<unsigned> mOutputs; //!< Patterns ending in each state
+
+    unsigned mState;
+    std::vector<unsigned long long> mTimes; //!< Last presses, power of two
+    unsigned mPressCount;
+    std::vector<unsigned> mActive; //!< Completed patterns, not released
+    std::vector<unsigned> mCompleted;
+};
+
+
+} // namespace oism
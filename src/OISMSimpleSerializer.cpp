@@ -5,6 +5,20 @@
 
 #include <algorithm>
 #include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#if defined __unix__ || defined __APPLE__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define OISM_USE_MMAP
+#elif defined _WIN32
+#include <windows.h>
+#endif
 
 // DEBUG
 #include <iostream>
@@ -15,69 +29,378 @@ using namespace oism;
 
 const char* g_map_filename = "inputmap";
 const char* g_conf_filename = "inputconf";
+const char* g_cache_suffix = ".cache";
 
 
-template<class Vec>
-bool linear_search(const Vec& v, const typename Vec::value_type& val)
+const char* enum_to_string(const NameTable& table, unsigned v)
 {
-    return std::find(v.begin(), v.end(), val) != v.end();
+    const char* name = table.name(v);
+    if (!name)
+    {
+        log::log(log::Level::Error, "Invalid enum: ", v);
+        return "__INVALID__";
+    }
+
+    return name;
+}
+
+
+bool is_negative(StringRef& str)
+{
+    if (!str.empty() && str.data[0] == '-')
+    {
+        ++str.data;
+        --str.size;
+        return true;
+    }
+    return false;
 }
 
 
-// Linear search for the value instead of the key
-template<class Map>
-typename Map::const_iterator reverse_map_search(const Map& m, const typename Map::mapped_type& v)
+bool is_space(char c)
 {
-    for (auto it = m.begin(); it != m.end(); it++) if (it->second == v) return it;
-    return m.end();
+    return c == ' ' || c == '\t' || c == '\r';
 }
 
 
-std::string enum_to_string(const NamedEnum& m, unsigned v)
+// Joystick axis filters, space separated 'joystick[.axis]:deadZone[:threshold]'
+std::string axis_filters_to_string(const std::vector<Handler::Configuration::JoyStickAxisFilter>& filters)
 {
-    auto it = reverse_map_search(m, v);
-    if (it == m.end()) 
+    std::string str;
+    char buf[64];
+    for (auto& f : filters)
     {
-        log::log("Invalid enum: "+std::to_string(v), log::Level::Error);
-        return "__INVALID__";
+        if (!str.empty()) str += ' ';
+        str += std::to_string(f.joystick);
+        if (f.axis >= 0) str += '.' + std::to_string(f.axis);
+        snprintf(buf, sizeof(buf), ":%g:%g", f.filter.deadZone, f.filter.threshold);
+        str += buf;
+    }
+    return str;
+}
+
+
+bool axis_filters_from_string(const std::string& str,
+                              std::vector<Handler::Configuration::JoyStickAxisFilter>& filters)
+{
+    filters.clear();
+    const char* p = str.c_str();
+    for (;;)
+    {
+        while (is_space(*p)) ++p;
+        if (!*p) return true;
+
+        Handler::Configuration::JoyStickAxisFilter f;
+        char* last;
+        f.joystick = strtoul(p, &last, 10);
+        if (last == p) return false;
+        p = last;
+
+        f.axis = -1;
+        if (*p == '.')
+        {
+            f.axis = strtoul(++p, &last, 10);
+            if (last == p) return false;
+            p = last;
+        }
+
+        if (*p != ':') return false;
+        f.filter.deadZone = strtof(++p, &last);
+        if (last == p) return false;
+        p = last;
+
+        if (*p == ':')
+        {
+            f.filter.threshold = strtof(++p, &last);
+            if (last == p) return false;
+            p = last;
+        }
+        filters.push_back(f);
     }
+}
+
+
+/*
+===========
+StringRef
+===========
+*/
 
-    return it->first;
+
+void StringRef::lower(std::string& out) const
+{
+    out.resize(size);
+    for (size_t i = 0; i < size; i++) out[i] = tolower(data[i]);
 }
 
 
-void to_lower(std::string& str)
+bool StringRef::iequals(const char* other) const
 {
-    for (auto& c : str) c = tolower(c);
+    for (size_t i = 0; i < size; i++)
+        if (!other[i] || tolower(data[i]) != tolower(other[i])) return false;
+    return !other[size];
 }
 
 
-bool is_negative(std::string& str)
+void StringRef::split(char token, StringRef& head, StringRef& rest) const
 {
-    if (!str.empty() && str[0] == '-')
+    const char* p = static_cast<const char*>(memchr(data, token, size));
+    if (!p)
     {
-        str.erase(str.begin());
+        head = *this;
+        rest = StringRef();
+        return;
+    }
+    head = StringRef(data, p - data);
+    rest = StringRef(p + 1, size - (p - data) - 1);
+}
+
+
+/*
+===========
+MappedFile
+===========
+*/
+
+
+namespace oism
+{
+
+// Read-only view of a whole file
+struct MappedFile
+{
+    MappedFile(const std::string& filename)
+    :   data(nullptr), size(0), opened(false)
+    {
+#ifdef OISM_USE_MMAP
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        opened = true;
+
+        struct stat st;
+        if (!fstat(fd, &st) && st.st_size > 0)
+        {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                data = static_cast<const char*>(p);
+                size = st.st_size;
+            }
+        }
+        close(fd);
+#else
+        std::ifstream ifs(filename, std::ios::binary);
+        if (!ifs.is_open()) return;
+        buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+        opened = true;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef OISM_USE_MMAP
+        if (data) munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    bool isOpen() const { return opened; }
+
+    const char* data;
+    size_t size; //!< Empty files aren't mapped
+    bool opened;
+#ifndef OISM_USE_MMAP
+    std::vector<char> buffer;
+#endif
+};
+
+} // namespace oism
+
+
+/*
+===========
+Binary cache
+===========
+*/
+
+
+// Layout, native byte order:
+//   CacheHeader
+//   For each binding:
+//     uint32 name length, name
+//     Key, mouse and joystick events: uint32 count, events (uint32)
+//     Filters: uint32 count, for each: uint32 type, float a, float b
+//     Sequences: uint32 count, for each: uint32 window, uint32 step count,
+//       for each step: uint32 name count, for each name: uint32 length, name
+
+const char g_cache_magic[4] = {'O', 'I', 'S', 'M'};
+const uint32_t g_cache_byte_order = 0x01020304;
+
+
+uint32_t cache_checksum(const char* data, size_t size)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++) h = (h ^ (unsigned char)data[i]) * 16777619u;
+    return h;
+}
+
+
+bool file_stat(const std::string& filename, int64_t& time, uint64_t& size)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st)) return false;
+#ifdef __linux__
+    // Edits within the same second must still invalidate the cache
+    time = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    time = st.st_mtime;
+#endif
+    size = st.st_size;
+    return true;
+}
+
+
+// Write to a temporary file next to 'filename' in a single call, then rename it
+// over 'filename' so readers never see a partial file
+bool atomic_write_file(const std::string& filename, const char* data, size_t size)
+{
+    std::string tmp = filename+".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+
+    bool ok = fwrite(data, 1, size, f) == size && !fflush(f);
+#ifdef OISM_USE_MMAP
+    ok = ok && !fsync(fileno(f));
+#endif
+    ok = !fclose(f) && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA(tmp.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && !rename(tmp.c_str(), filename.c_str());
+#endif
+
+    if (!ok) remove(tmp.c_str());
+    return ok;
+}
+
+
+// Bounds checked reads from the mapped cache
+struct CacheReader
+{
+    CacheReader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+    bool read(void* dst, size_t n)
+    {
+        if ((size_t)(end - pos) < n) return false;
+        memcpy(dst, pos, n);
+        pos += n;
         return true;
     }
-    return false;
+    bool readEvents(Bind* b, void (Bind::*add)(InputEvent::Type))
+    {
+        uint32_t count, evt;
+        if (!read(&count, sizeof(count))) return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!read(&evt, sizeof(evt))) return false;
+            (b->*add)(evt);
+        }
+        return true;
+    }
+    bool readFilters(Bind* b)
+    {
+        uint32_t count, type;
+        float a, c;
+        if (!read(&count, sizeof(count))) return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!read(&type, sizeof(type)) || !read(&a, sizeof(a)) || !read(&c, sizeof(c))) return false;
+            b->addFilter(FilterStage::create(type, a, c));
+        }
+        return true;
+    }
+
+    bool readString(std::string& str)
+    {
+        uint32_t length;
+        if (!read(&length, sizeof(length)) || (size_t)(end - pos) < length) return false;
+        str.assign(pos, length);
+        pos += length;
+        return true;
+    }
+    bool readSequences(Bind* b)
+    {
+        uint32_t count, window, stepCount, nameCount;
+        if (!read(&count, sizeof(count))) return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!read(&window, sizeof(window)) || !read(&stepCount, sizeof(stepCount))) return false;
+            BindSequence sequence(window);
+            sequence.steps.resize(stepCount);
+            for (auto& step : sequence.steps)
+            {
+                if (!read(&nameCount, sizeof(nameCount))) return false;
+                step.resize(nameCount);
+                for (auto& name : step) if (!readString(name)) return false;
+            }
+            b->addSequence(sequence);
+        }
+        return true;
+    }
+
+    const char* pos;
+    const char* end;
+};
+
+
+template <class T>
+void cache_write(std::string& buf, const T& t)
+{
+    buf.append(reinterpret_cast<const char*>(&t), sizeof(T));
 }
 
 
-// Return number of splits
-int split_word(char token, const std::string& word, std::vector<std::string>& splits)
+void cache_write_events(std::string& buf, const Bind::InputEventList& events)
 {
-    size_t prev = 0; 
-    size_t next = 0; 
-    splits.clear();
+    cache_write(buf, (uint32_t)events.size());
+    for (auto evt : events) cache_write(buf, (uint32_t)evt);
+}
 
-    while (next < word.size())
+
+void cache_write_filters(std::string& buf, const FilterChain& filters)
+{
+    cache_write(buf, (uint32_t)filters.size());
+    for (auto& stage : filters)
     {
-        next = word.find_first_of(token, prev);
-        splits.push_back(word.substr(prev, next));
-        prev = next + 1;
+        cache_write(buf, (uint32_t)stage.type);
+        cache_write(buf, stage.a);
+        cache_write(buf, stage.b);
     }
+}
+
+
+void cache_write_string(std::string& buf, const std::string& str)
+{
+    cache_write(buf, (uint32_t)str.size());
+    buf.append(str);
+}
+
 
-    return splits.size();
+void cache_write_sequences(std::string& buf, const std::vector<BindSequence>& sequences)
+{
+    cache_write(buf, (uint32_t)sequences.size());
+    for (auto& sequence : sequences)
+    {
+        cache_write(buf, (uint32_t)sequence.window);
+        cache_write(buf, (uint32_t)sequence.steps.size());
+        for (auto& step : sequence.steps)
+        {
+            cache_write(buf, (uint32_t)step.size());
+            for (auto& name : step) cache_write_string(buf, name);
+        }
+    }
 }
 
 
@@ -88,122 +411,582 @@ File
 */
 
 
-File::File(const std::string& filename)
-:   fs(filename), filename(filename), wend(0), lineNum(0)
+File::File(const std::string& filename, Mode mode/* = M_Read*/)
+:   pendingWrite(mode == M_Write),
+    filename(filename), lineNum(0),
+    pos(nullptr), end(nullptr), lineEnd(nullptr),
+    keysIndexed(false)
 {
-    if (!fs.is_open())
+    if (mode == M_Write)
+    {
+        out.reserve(4096);
+        return;
+    }
+
+    mapped.reset(new MappedFile(filename));
+    if (!mapped->isOpen())
     {
         // Attempt to create file
-        {
-            std::ofstream ofs(filename);
-            if (!ofs.good()) log::log("Error creating file: "+filename, log::Level::Error);
-        }
-        
-        fs.open(filename);
-        if (!fs.is_open())
-            log::log("Error opening file: "+filename, log::Level::Error);
+        std::ofstream ofs(filename, std::ios::app);
+        if (!ofs.good()) log::log(log::Level::Error, "Error opening file: ", filename);
+        return;
     }
-} 
+
+    pos = lineEnd = mapped->data;
+    end = mapped->data + mapped->size;
+}
+
+
+File::~File()
+{
+    if (pendingWrite) commit();
+}
+
 
 bool File::isOpen()
 {
-    return fs.is_open();
+    return mapped ? mapped->isOpen() : pendingWrite;
 }
 
 
-int File::nextWord(std::string& str)
+void File::write(int n)
 {
-    size_t wstart = line.find_first_not_of(' ', wend);
-    if (wstart == std::string::npos) return 0;
-    wend = line.find_first_of(' ', wstart);
-    str = line.substr(wstart, wend - wstart);
-    to_lower(str);
-    return str.size();
+    char buf[16];
+    out.append(buf, snprintf(buf, sizeof(buf), "%d", n));
 }
 
 
-int File::nextNumber(int& num)
+void File::write(unsigned n)
 {
-    std::string str;
-    if (!nextWord(str)) return 0;
+    char buf[16];
+    out.append(buf, snprintf(buf, sizeof(buf), "%u", n));
+}
+
+
+void File::write(float f)
+{
+    // Same as the default stream formatting
+    char buf[32];
+    out.append(buf, snprintf(buf, sizeof(buf), "%g", f));
+}
+
+
+bool File::commit()
+{
+    pendingWrite = false;
+    if (atomic_write_file(filename, out.data(), out.size())) return true;
+
+    log::log(log::Level::Error, "Error writing file: ", filename);
+    return false;
+}
+
+
+bool File::nextLine()
+{
+    // Skip the rest of the current line
+    pos = lineEnd;
+    if (pos < end && *pos == '\n') ++pos;
+    if (pos >= end) return false;
 
-    try
+    const char* nl = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    lineEnd = nl ? nl : end;
+    ++lineNum;
+    return true;
+}
+
+
+bool File::nextWord(StringRef& str)
+{
+    while (pos < lineEnd && is_space(*pos)) ++pos;
+    if (pos == lineEnd) return false;
+
+    const char* start = pos;
+    while (pos < lineEnd && !is_space(*pos)) ++pos;
+    str = StringRef(start, pos - start);
+    return true;
+}
+
+
+bool File::nextNumber(int& num)
+{
+    StringRef str;
+    if (!nextWord(str)) return false;
+
+    size_t i = 0;
+    bool neg = str.data[0] == '-';
+    if (neg || str.data[0] == '+') ++i;
+
+    if (i == str.size)
     {
-        num = std::stoi(str);
-        return str.size();
+        log::log(log::Level::Error, "File: ", filename, " On line:", lineNum, " -- Expected a number:", str.str());
+        return false;
     }
-    catch (const std::invalid_argument& e)
+
+    // Magnitude of INT_MIN doesn't fit in an int
+    const unsigned limit = neg ? 0u - (unsigned)INT_MIN : (unsigned)INT_MAX;
+    unsigned n = 0;
+    for (; i < str.size; i++)
     {
-        log::log("File: "+filename+" On line:"+std::to_string(lineNum)+" -- Expected a number:"+str, log::Level::Error);
+        if (str.data[i] < '0' || str.data[i] > '9')
+        {
+            log::log(log::Level::Error, "File: ", filename, " On line:", lineNum, " -- Expected a number:", str.str());
+            return false;
+        }
+        unsigned digit = str.data[i] - '0';
+        if (n > (limit - digit) / 10)
+        {
+            log::log(log::Level::Error, "File: ", filename, " On line:", lineNum, " -- Number out of range:", str.str());
+            return false;
+        }
+        n = n * 10 + digit;
     }
-    return 0;
+
+    num = neg ? (int)(-(long long)n) : (int)n;
+    return true;
 }
 
 
-int File::nextLine()
+bool File::nextFloat(float& num)
 {
-    wend = 0;
-    std::getline(fs, line);
-    ++lineNum;
-    return line.size();
+    StringRef str;
+    if (!nextWord(str)) return false;
+
+    char buf[64];
+    size_t size = std::min(str.size, sizeof(buf) - 1);
+    memcpy(buf, str.data, size);
+    buf[size] = '\0';
+
+    char* last;
+    float f = strtof(buf, &last);
+    if (last != buf + size)
+    {
+        log::log(log::Level::Error, "File: ", filename, " On line:", lineNum, " -- Expected a number:", str.str());
+        return false;
+    }
+    num = f;
+    return true;
 }
 
 
-std::string File::_findKey(const std::string& key)
+bool File::hasKey(const std::string& key)
 {
-    std::string line;
-    while (std::getline(fs, line))
-    {
-        size_t start = line.find_first_not_of(' ');
-        size_t end = line.find_first_of(' ', start);
+    _indexKeys();
+    return keys.count(key);
+}
 
-        if (end == std::string::npos)
-            continue;
 
-        if (!line.compare(start, end - start, key))
-            return line.substr(end);
+StringRef File::_findKey(const std::string& key)
+{
+    _indexKeys();
+    auto it = keys.find(key);
+    if (it == keys.end())
+    {
+        log::log(log::Level::Error, "File: ", filename, " Key not found '", key, "'");
+        return StringRef();
     }
-    log::log("File: "+filename+" Key not found '"+key+"'", log::Level::Error);
-    return "";
+    return it->second;
 }
 
 
-bool File::readKeyValuePair(const std::string& key, int& value)
+void File::_indexKeys()
 {
-    std::string val = _findKey(key);
-    try
+    if (keysIndexed) return;
+
+    // Index every 'key value' line at once, last one win
+    keysIndexed = true;
+    std::string lowerKey;
+    StringRef k;
+    while (nextLine())
     {
-        value = std::stod(val);
-        return val.size();
+        if (!nextWord(k)) continue;
+        while (pos < lineEnd && is_space(*pos)) ++pos;
+
+        const char* valueEnd = lineEnd;
+        while (valueEnd > pos && is_space(valueEnd[-1])) --valueEnd;
+
+        k.lower(lowerKey);
+        keys[lowerKey] = StringRef(pos, valueEnd - pos);
     }
-    catch (const std::invalid_argument& e)
+}
+
+
+bool File::readKeyValuePair(const std::string& key, int& value)
+{
+    StringRef val = _findKey(key);
+    if (val.empty()) return false;
+
+    char buf[32];
+    size_t size = std::min(val.size, sizeof(buf) - 1);
+    memcpy(buf, val.data, size);
+    buf[size] = '\0';
+
+    char* last;
+    long n = strtol(buf, &last, 10);
+    if (last == buf)
     {
-        log::log("File: "+filename+" Integer expected for key: '"+key+"'", log::Level::Error);
+        log::log(log::Level::Error, "File: ", filename, " Integer expected for key: '", key, "'");
+        return false;
     }
-    return 0;
+    value = n;
+    return true;
 }
 
 
 bool File::readKeyValuePair(const std::string& key, float& value)
 {
-    std::string val = _findKey(key);
-    try
+    StringRef val = _findKey(key);
+    if (val.empty()) return false;
+
+    char buf[64];
+    size_t size = std::min(val.size, sizeof(buf) - 1);
+    memcpy(buf, val.data, size);
+    buf[size] = '\0';
+
+    char* last;
+    float f = strtof(buf, &last);
+    if (last == buf)
     {
-        value = std::stof(val);
-        return val.size();
+        log::log(log::Level::Error, "File: ", filename, " Floating point number expected for key: '", key, "'");
+        return false;
     }
-    catch (const std::invalid_argument& e)
+    value = f;
+    return true;
+}
+
+
+bool File::readKeyValuePair(const std::string& key, bool& value)
+{
+    int n;
+    if (!readKeyValuePair(key, n)) return false;
+    value = n;
+    return true;
+}
+
+
+bool File::readKeyValuePair(const std::string& key, std::string& value)
+{
+    StringRef val = _findKey(key);
+    value = val.str();
+    return !val.empty();
+}
+
+
+/*
+===========
+Name tables
+===========
+*/
+
+
+const NamedValue g_key_names[] =
+{
+    {"escape", OIS::KC_ESCAPE},
+    {"1", OIS::KC_1},
+    {"2", OIS::KC_2},
+    {"3", OIS::KC_3},
+    {"4", OIS::KC_4},
+    {"5", OIS::KC_5},
+    {"6", OIS::KC_6},
+    {"7", OIS::KC_7},
+    {"8", OIS::KC_8},
+    {"9", OIS::KC_9},
+    {"0", OIS::KC_0},
+    {"minus", OIS::KC_MINUS},
+    {"equals", OIS::KC_EQUALS},
+    {"back", OIS::KC_BACK},
+    {"tab", OIS::KC_TAB},
+    {"q", OIS::KC_Q},
+    {"w", OIS::KC_W},
+    {"e", OIS::KC_E},
+    {"r", OIS::KC_R},
+    {"t", OIS::KC_T},
+    {"y", OIS::KC_Y},
+    {"u", OIS::KC_U},
+    {"i", OIS::KC_I},
+    {"o", OIS::KC_O},
+    {"p", OIS::KC_P},
+    {"lbracket", OIS::KC_LBRACKET},
+    {"rbracket", OIS::KC_RBRACKET},
+    {"return", OIS::KC_RETURN},
+    {"lcontrol", OIS::KC_LCONTROL},
+    {"a", OIS::KC_A},
+    {"s", OIS::KC_S},
+    {"d", OIS::KC_D},
+    {"f", OIS::KC_F},
+    {"g", OIS::KC_G},
+    {"h", OIS::KC_H},
+    {"j", OIS::KC_J},
+    {"k", OIS::KC_K},
+    {"l", OIS::KC_L},
+    {"semicolon", OIS::KC_SEMICOLON},
+    {"apostrophe", OIS::KC_APOSTROPHE},
+    {"grave", OIS::KC_GRAVE},
+    {"lshift", OIS::KC_LSHIFT},
+    {"backslash", OIS::KC_BACKSLASH},
+    {"z", OIS::KC_Z},
+    {"x", OIS::KC_X},
+    {"c", OIS::KC_C},
+    {"v", OIS::KC_V},
+    {"b", OIS::KC_B},
+    {"n", OIS::KC_N},
+    {"m", OIS::KC_M},
+    {"comma", OIS::KC_COMMA},
+    {"period", OIS::KC_PERIOD},
+    {"slash", OIS::KC_SLASH},
+    {"rshift", OIS::KC_RSHIFT},
+    {"multiply", OIS::KC_MULTIPLY},
+    {"lalt", OIS::KC_LMENU},
+    {"space", OIS::KC_SPACE},
+    {"capital", OIS::KC_CAPITAL},
+    {"f1", OIS::KC_F1},
+    {"f2", OIS::KC_F2},
+    {"f3", OIS::KC_F3},
+    {"f4", OIS::KC_F4},
+    {"f5", OIS::KC_F5},
+    {"f6", OIS::KC_F6},
+    {"f7", OIS::KC_F7},
+    {"f8", OIS::KC_F8},
+    {"f9", OIS::KC_F9},
+    {"f10", OIS::KC_F10},
+    {"numlock", OIS::KC_NUMLOCK},
+    {"scroll", OIS::KC_SCROLL},
+    {"numpad7", OIS::KC_NUMPAD7},
+    {"numpad8", OIS::KC_NUMPAD8},
+    {"numpad9", OIS::KC_NUMPAD9},
+    {"subtract", OIS::KC_SUBTRACT},
+    {"numpad4", OIS::KC_NUMPAD4},
+    {"numpad5", OIS::KC_NUMPAD5},
+    {"numpad6", OIS::KC_NUMPAD6},
+    {"add", OIS::KC_ADD},
+    {"numpad1", OIS::KC_NUMPAD1},
+    {"numpad2", OIS::KC_NUMPAD2},
+    {"numpad3", OIS::KC_NUMPAD3},
+    {"numpad0", OIS::KC_NUMPAD0},
+    {"decimal", OIS::KC_DECIMAL},
+    {"oem_102", OIS::KC_OEM_102},
+    {"f11", OIS::KC_F11},
+    {"f12", OIS::KC_F12},
+    {"f13", OIS::KC_F13},
+    {"f14", OIS::KC_F14},
+    {"f15", OIS::KC_F15},
+    {"kana", OIS::KC_KANA},
+    {"abnt_c1", OIS::KC_ABNT_C1},
+    {"convert", OIS::KC_CONVERT},
+    {"noconvert", OIS::KC_NOCONVERT},
+    {"yen", OIS::KC_YEN},
+    {"abnt_c2", OIS::KC_ABNT_C2},
+    {"numpadequals", OIS::KC_NUMPADEQUALS},
+    {"prevtrack", OIS::KC_PREVTRACK},
+    {"at", OIS::KC_AT},
+    {"colon", OIS::KC_COLON},
+    {"underline", OIS::KC_UNDERLINE},
+    {"kanji", OIS::KC_KANJI},
+    {"stop", OIS::KC_STOP},
+    {"ax", OIS::KC_AX},
+    {"unlabeled", OIS::KC_UNLABELED},
+    {"nexttrack", OIS::KC_NEXTTRACK},
+    {"numpadenter", OIS::KC_NUMPADENTER},
+    {"rcontrol", OIS::KC_RCONTROL},
+    {"mute", OIS::KC_MUTE},
+    {"calculator", OIS::KC_CALCULATOR},
+    {"playpause", OIS::KC_PLAYPAUSE},
+    {"mediastop", OIS::KC_MEDIASTOP},
+    {"volumedown", OIS::KC_VOLUMEDOWN},
+    {"volumeup", OIS::KC_VOLUMEUP},
+    {"webhome", OIS::KC_WEBHOME},
+    {"numpadcomma", OIS::KC_NUMPADCOMMA},
+    {"divide", OIS::KC_DIVIDE},
+    {"sysrq", OIS::KC_SYSRQ},
+    {"ralt", OIS::KC_RMENU},
+    {"pause", OIS::KC_PAUSE},
+    {"home", OIS::KC_HOME},
+    {"up", OIS::KC_UP},
+    {"pgup", OIS::KC_PGUP},
+    {"left", OIS::KC_LEFT},
+    {"right", OIS::KC_RIGHT},
+    {"end", OIS::KC_END},
+    {"down", OIS::KC_DOWN},
+    {"pgdown", OIS::KC_PGDOWN},
+    {"insert", OIS::KC_INSERT},
+    {"delete", OIS::KC_DELETE},
+    {"lwin", OIS::KC_LWIN},
+    {"rwin", OIS::KC_RWIN},
+    {"apps", OIS::KC_APPS},
+    {"power", OIS::KC_POWER},
+    {"sleep", OIS::KC_SLEEP},
+    {"wake", OIS::KC_WAKE},
+    {"websearch", OIS::KC_WEBSEARCH},
+    {"webfavorites", OIS::KC_WEBFAVORITES},
+    {"webrefresh", OIS::KC_WEBREFRESH},
+    {"webstop", OIS::KC_WEBSTOP},
+    {"webforward", OIS::KC_WEBFORWARD},
+    {"webback", OIS::KC_WEBBACK},
+    {"mycomputer", OIS::KC_MYCOMPUTER},
+    {"mail", OIS::KC_MAIL},
+    {"mediaselect", OIS::KC_MEDIASELECT},
+};
+
+
+const NamedValue g_key_modifier_names[] =
+{
+    {"alt", OIS::Keyboard::Alt},
+    {"ctrl", OIS::Keyboard::Ctrl},
+    {"shift", OIS::Keyboard::Shift},
+};
+
+
+const NamedValue g_mouse_component_names[] =
+{
+    {"left", MouseEvent::Component::CPNT_LEFT},
+    {"right", MouseEvent::Component::CPNT_RIGHT},
+    {"middle", MouseEvent::Component::CPNT_MIDDLE},
+    {"button3", MouseEvent::Component::CPNT_BUTTON3},
+    {"button4", MouseEvent::Component::CPNT_BUTTON4},
+    {"button5", MouseEvent::Component::CPNT_BUTTON5},
+    {"button6", MouseEvent::Component::CPNT_BUTTON6},
+    {"button7", MouseEvent::Component::CPNT_BUTTON7},
+    {"axis_x", MouseEvent::Component::CPNT_AXIS_X},
+    {"axis_y", MouseEvent::Component::CPNT_AXIS_Y},
+    {"axis_z", MouseEvent::Component::CPNT_AXIS_Z},
+};
+
+
+const NamedValue g_joystick_component_names[] =
+{
+    {"button", OIS::OIS_Button},
+    {"axis", OIS::OIS_Axis},
+    {"slider", OIS::OIS_Slider},
+    {"pov", OIS::OIS_POV},
+    {"vector3", OIS::OIS_Vector3},
+};
+
+
+const NamedValue g_filter_names[] =
+{
+    {"scale", FilterStage::FT_SCALE},
+    {"smooth", FilterStage::FT_SMOOTH},
+    {"power", FilterStage::FT_POWER},
+    {"bezier", FilterStage::FT_BEZIER},
+    {"accel", FilterStage::FT_ACCEL},
+    {"ramp", FilterStage::FT_RAMP},
+};
+
+
+// Filters and sequences aren't devices, they share the binding line format
+enum DeviceType {DT_KEYBOARD, DT_MOUSE, DT_JOYSTICK, DT_FILTER, DT_SEQUENCE};
+const NamedValue g_device_names[] =
+{
+    {"k", DT_KEYBOARD},
+    {"kb", DT_KEYBOARD},
+    {"key", DT_KEYBOARD},
+    {"keyboard", DT_KEYBOARD},
+    {"m", DT_MOUSE},
+    {"ms", DT_MOUSE},
+    {"mouse", DT_MOUSE},
+    {"j", DT_JOYSTICK},
+    {"js", DT_JOYSTICK},
+    {"joystick", DT_JOYSTICK},
+    {"f", DT_FILTER},
+    {"filter", DT_FILTER},
+    {"seq", DT_SEQUENCE},
+    {"sequence", DT_SEQUENCE},
+};
+
+
+// Lowercase FNV-1a, seeded
+uint32_t hash_lower(const char* str, size_t size, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < size; i++) h = (h ^ (unsigned char)tolower(str[i])) * 16777619u;
+    return h;
+}
+
+
+void NameTable::build()
+{
+    unsigned maxValue = 0;
+    for (unsigned i = 0; i < mCount; i++) maxValue = std::max(maxValue, mEntries[i].value);
+
+    // Reverse table, first name win
+    mNames.assign(maxValue + 1, nullptr);
+    for (unsigned i = 0; i < mCount; i++)
+        if (!mNames[mEntries[i].value]) mNames[mEntries[i].value] = mEntries[i].name;
+
+    // Search a seed without collision, grow the table if it takes too long
+    unsigned size = 2;
+    while (size < mCount * 2) size <<= 1;
+    for (mSeed = 0;; mSeed++)
     {
-        log::log("File: "+filename+" Floating point number expected for key: '"+key+"'", log::Level::Error);
+        if (mSeed && !(mSeed % 1024)) size <<= 1;
+        mMask = size - 1;
+        mSlots.assign(size, 0);
+
+        unsigned i = 0;
+        for (; i < mCount; i++)
+        {
+            unsigned short& s = mSlots[slot(mEntries[i].name, strlen(mEntries[i].name))];
+            if (s) break;
+            s = i + 1;
+        }
+        if (i == mCount) break;
     }
-    return 0;
 }
 
 
-bool File::readKeyValuePair(const std::string& key, std::string& value)
+unsigned NameTable::slot(const char* str, size_t size) const
+{
+    return hash_lower(str, size, mSeed) & mMask;
+}
+
+
+bool NameTable::find(const StringRef& name, unsigned& value) const
+{
+    unsigned idx = mSlots[slot(name.data, name.size)];
+    if (!idx || !name.iequals(mEntries[idx - 1].name)) return false;
+    value = mEntries[idx - 1].value;
+    return true;
+}
+
+
+const NameTable& SimpleSerializer::keyNames()
+{
+    static const NameTable table(g_key_names);
+    return table;
+}
+
+
+const NameTable& SimpleSerializer::keyModifierNames()
 {
-    value = _findKey(key);
-    return value.size();
+    static const NameTable table(g_key_modifier_names);
+    return table;
+}
+
+
+const NameTable& SimpleSerializer::mouseComponentNames()
+{
+    static const NameTable table(g_mouse_component_names);
+    return table;
+}
+
+
+const NameTable& SimpleSerializer::joyStickComponentNames()
+{
+    static const NameTable table(g_joystick_component_names);
+    return table;
+}
+
+
+const NameTable& SimpleSerializer::filterNames()
+{
+    static const NameTable table(g_filter_names);
+    return table;
+}
+
+
+const NameTable& SimpleSerializer::deviceNames()
+{
+    static const NameTable table(g_device_names);
+    return table;
 }
 
 
@@ -215,225 +998,145 @@ SimpleSerializer
 
 
 SimpleSerializer::SimpleSerializer(const std::string& path)
-:   Serializer(path),
-    mKeyNames(145),
-    mKeyModifierNames(3),
-    mMouseComponentNames(11),
-    mJoyStickComponentNames(5),
-    mKeyboardDeviceNames(5),
-    mMouseDeviceNames(3),
-    mJoyStickDeviceNames(3)
-
-{
-    mKeyNames["escape"] = OIS::KC_ESCAPE;
-    mKeyNames["1"] = OIS::KC_1;
-    mKeyNames["2"] = OIS::KC_2;
-    mKeyNames["3"] = OIS::KC_3;
-    mKeyNames["4"] = OIS::KC_4;
-    mKeyNames["5"] = OIS::KC_5;
-    mKeyNames["6"] = OIS::KC_6;
-    mKeyNames["7"] = OIS::KC_7;
-    mKeyNames["8"] = OIS::KC_8;
-    mKeyNames["9"] = OIS::KC_9;
-    mKeyNames["0"] = OIS::KC_0;
-    mKeyNames["minus"] = OIS::KC_MINUS;
-    mKeyNames["equals"] = OIS::KC_EQUALS;
-    mKeyNames["back"] = OIS::KC_BACK;
-    mKeyNames["tab"] = OIS::KC_TAB;
-    mKeyNames["q"] = OIS::KC_Q;
-    mKeyNames["w"] = OIS::KC_W;
-    mKeyNames["e"] = OIS::KC_E;
-    mKeyNames["r"] = OIS::KC_R;
-    mKeyNames["t"] = OIS::KC_T;
-    mKeyNames["y"] = OIS::KC_Y;
-    mKeyNames["u"] = OIS::KC_U;
-    mKeyNames["i"] = OIS::KC_I;
-    mKeyNames["o"] = OIS::KC_O;
-    mKeyNames["p"] = OIS::KC_P;
-    mKeyNames["lbracket"] = OIS::KC_LBRACKET;
-    mKeyNames["rbracket"] = OIS::KC_RBRACKET;
-    mKeyNames["return"] = OIS::KC_RETURN;
-    mKeyNames["lcontrol"] = OIS::KC_LCONTROL;
-    mKeyNames["a"] = OIS::KC_A;
-    mKeyNames["s"] = OIS::KC_S;
-    mKeyNames["d"] = OIS::KC_D;
-    mKeyNames["f"] = OIS::KC_F;
-    mKeyNames["g"] = OIS::KC_G;
-    mKeyNames["h"] = OIS::KC_H;
-    mKeyNames["j"] = OIS::KC_J;
-    mKeyNames["k"] = OIS::KC_K;
-    mKeyNames["l"] = OIS::KC_L;
-    mKeyNames["semicolon"] = OIS::KC_SEMICOLON;
-    mKeyNames["apostrophe"] = OIS::KC_APOSTROPHE;
-    mKeyNames["grave"] = OIS::KC_GRAVE;
-    mKeyNames["lshift"] = OIS::KC_LSHIFT;
-    mKeyNames["backslash"] = OIS::KC_BACKSLASH;
-    mKeyNames["z"] = OIS::KC_Z;
-    mKeyNames["x"] = OIS::KC_X;
-    mKeyNames["c"] = OIS::KC_C;
-    mKeyNames["v"] = OIS::KC_V;
-    mKeyNames["b"] = OIS::KC_B;
-    mKeyNames["n"] = OIS::KC_N;
-    mKeyNames["m"] = OIS::KC_M;
-    mKeyNames["comma"] = OIS::KC_COMMA;
-    mKeyNames["period"] = OIS::KC_PERIOD;
-    mKeyNames["slash"] = OIS::KC_SLASH;
-    mKeyNames["rshift"] = OIS::KC_RSHIFT;
-    mKeyNames["multiply"] = OIS::KC_MULTIPLY;
-    mKeyNames["lalt"] = OIS::KC_LMENU;
-    mKeyNames["space"] = OIS::KC_SPACE;
-    mKeyNames["capital"] = OIS::KC_CAPITAL;
-    mKeyNames["f1"] = OIS::KC_F1;
-    mKeyNames["f2"] = OIS::KC_F2;
-    mKeyNames["f3"] = OIS::KC_F3;
-    mKeyNames["f4"] = OIS::KC_F4;
-    mKeyNames["f5"] = OIS::KC_F5;
-    mKeyNames["f6"] = OIS::KC_F6;
-    mKeyNames["f7"] = OIS::KC_F7;
-    mKeyNames["f8"] = OIS::KC_F8;
-    mKeyNames["f9"] = OIS::KC_F9;
-    mKeyNames["f10"] = OIS::KC_F10;
-    mKeyNames["numlock"] = OIS::KC_NUMLOCK;
-    mKeyNames["scroll"] = OIS::KC_SCROLL;
-    mKeyNames["numpad7"] = OIS::KC_NUMPAD7;
-    mKeyNames["numpad8"] = OIS::KC_NUMPAD8;
-    mKeyNames["numpad9"] = OIS::KC_NUMPAD9;
-    mKeyNames["subtract"] = OIS::KC_SUBTRACT;
-    mKeyNames["numpad4"] = OIS::KC_NUMPAD4;
-    mKeyNames["numpad5"] = OIS::KC_NUMPAD5;
-    mKeyNames["numpad6"] = OIS::KC_NUMPAD6;
-    mKeyNames["add"] = OIS::KC_ADD;
-    mKeyNames["numpad1"] = OIS::KC_NUMPAD1;
-    mKeyNames["numpad2"] = OIS::KC_NUMPAD2;
-    mKeyNames["numpad3"] = OIS::KC_NUMPAD3;
-    mKeyNames["numpad0"] = OIS::KC_NUMPAD0;
-    mKeyNames["decimal"] = OIS::KC_DECIMAL;
-    mKeyNames["oem_102"] = OIS::KC_OEM_102;
-    mKeyNames["f11"] = OIS::KC_F11;
-    mKeyNames["f12"] = OIS::KC_F12;
-    mKeyNames["f13"] = OIS::KC_F13;
-    mKeyNames["f14"] = OIS::KC_F14;
-    mKeyNames["f15"] = OIS::KC_F15;
-    mKeyNames["kana"] = OIS::KC_KANA;
-    mKeyNames["abnt_c1"] = OIS::KC_ABNT_C1;
-    mKeyNames["convert"] = OIS::KC_CONVERT;
-    mKeyNames["noconvert"] = OIS::KC_NOCONVERT;
-    mKeyNames["yen"] = OIS::KC_YEN;
-    mKeyNames["abnt_c2"] = OIS::KC_ABNT_C2;
-    mKeyNames["numpadequals"] = OIS::KC_NUMPADEQUALS;
-    mKeyNames["prevtrack"] = OIS::KC_PREVTRACK;
-    mKeyNames["at"] = OIS::KC_AT;
-    mKeyNames["colon"] = OIS::KC_COLON;
-    mKeyNames["underline"] = OIS::KC_UNDERLINE;
-    mKeyNames["kanji"] = OIS::KC_KANJI;
-    mKeyNames["stop"] = OIS::KC_STOP;
-    mKeyNames["ax"] = OIS::KC_AX;
-    mKeyNames["unlabeled"] = OIS::KC_UNLABELED;
-    mKeyNames["nexttrack"] = OIS::KC_NEXTTRACK;
-    mKeyNames["numpadenter"] = OIS::KC_NUMPADENTER;
-    mKeyNames["rcontrol"] = OIS::KC_RCONTROL;
-    mKeyNames["mute"] = OIS::KC_MUTE;
-    mKeyNames["calculator"] = OIS::KC_CALCULATOR;
-    mKeyNames["playpause"] = OIS::KC_PLAYPAUSE;
-    mKeyNames["mediastop"] = OIS::KC_MEDIASTOP;
-    mKeyNames["volumedown"] = OIS::KC_VOLUMEDOWN;
-    mKeyNames["volumeup"] = OIS::KC_VOLUMEUP;
-    mKeyNames["webhome"] = OIS::KC_WEBHOME;
-    mKeyNames["numpadcomma"] = OIS::KC_NUMPADCOMMA;
-
-    mKeyNames["divide"] = OIS::KC_DIVIDE;
-    mKeyNames["sysrq"] = OIS::KC_SYSRQ;
-    mKeyNames["ralt"] = OIS::KC_RMENU;
-    mKeyNames["pause"] = OIS::KC_PAUSE;
-    mKeyNames["home"] = OIS::KC_HOME;
-    mKeyNames["up"] = OIS::KC_UP;
-    mKeyNames["pgup"] = OIS::KC_PGUP;
-    mKeyNames["left"] = OIS::KC_LEFT;
-    mKeyNames["right"] = OIS::KC_RIGHT;
-    mKeyNames["end"] = OIS::KC_END;
-    mKeyNames["down"] = OIS::KC_DOWN;
-    mKeyNames["pgdown"] = OIS::KC_PGDOWN;
-    mKeyNames["insert"] = OIS::KC_INSERT;
-    mKeyNames["delete"] = OIS::KC_DELETE;
-    mKeyNames["lwin"] = OIS::KC_LWIN;
-    mKeyNames["rwin"] = OIS::KC_RWIN;
-    mKeyNames["apps"] = OIS::KC_APPS;
-    mKeyNames["power"] = OIS::KC_POWER;
-    mKeyNames["sleep"] = OIS::KC_SLEEP;
-    mKeyNames["wake"] = OIS::KC_WAKE;
-    mKeyNames["websearch"] = OIS::KC_WEBSEARCH;
-    mKeyNames["webfavorites"] = OIS::KC_WEBFAVORITES;
-    mKeyNames["webrefresh"] = OIS::KC_WEBREFRESH;
-    mKeyNames["webstop"] = OIS::KC_WEBSTOP;
-    mKeyNames["webforward"] = OIS::KC_WEBFORWARD;
-    mKeyNames["webback"] = OIS::KC_WEBBACK;
-    mKeyNames["mycomputer"] = OIS::KC_MYCOMPUTER;
-    mKeyNames["mail"] = OIS::KC_MAIL;
-    mKeyNames["mediaselect"] = OIS::KC_MEDIASELECT;
-
-    mKeyModifierNames["alt"] = OIS::Keyboard::Alt;
-    mKeyModifierNames["ctrl"] = OIS::Keyboard::Ctrl;
-    mKeyModifierNames["shift"] = OIS::Keyboard::Shift;
-
-    mMouseComponentNames["left"] = MouseEvent::Component::CPNT_LEFT;
-    mMouseComponentNames["right"] = MouseEvent::Component::CPNT_RIGHT;
-    mMouseComponentNames["middle"] = MouseEvent::Component::CPNT_MIDDLE;
-    mMouseComponentNames["button3"] = MouseEvent::Component::CPNT_BUTTON3;
-    mMouseComponentNames["button4"] = MouseEvent::Component::CPNT_BUTTON4;
-    mMouseComponentNames["button5"] = MouseEvent::Component::CPNT_BUTTON5;
-    mMouseComponentNames["button6"] = MouseEvent::Component::CPNT_BUTTON6;
-    mMouseComponentNames["button7"] = MouseEvent::Component::CPNT_BUTTON7;
-    mMouseComponentNames["axis_x"] = MouseEvent::Component::CPNT_AXIS_X;
-    mMouseComponentNames["axis_y"] = MouseEvent::Component::CPNT_AXIS_Y;
-    mMouseComponentNames["axis_z"] = MouseEvent::Component::CPNT_AXIS_Z;
-
-    mJoyStickComponentNames["button"] = OIS::OIS_Button;
-    mJoyStickComponentNames["axis"] = OIS::OIS_Axis;
-    mJoyStickComponentNames["slider"] = OIS::OIS_Slider;
-    mJoyStickComponentNames["pov"] = OIS::OIS_POV;
-    mJoyStickComponentNames["vector3"] = OIS::OIS_Vector3;
-
-    mKeyboardDeviceNames.emplace_back("k");
-    mKeyboardDeviceNames.emplace_back("kb");
-    mKeyboardDeviceNames.emplace_back("key");
-    mKeyboardDeviceNames.emplace_back("keyboard");
-    
-    mMouseDeviceNames.emplace_back("m");
-    mMouseDeviceNames.emplace_back("ms");
-    mMouseDeviceNames.emplace_back("mouse");
-    
-    mJoyStickDeviceNames.emplace_back("j");
-    mJoyStickDeviceNames.emplace_back("js");
-    mJoyStickDeviceNames.emplace_back("joystick");
+:   Serializer(path)
+{
 }
 
 
 void SimpleSerializer::loadBinding(NamedBindingMap& map)
 {
-    File fr(mPath+g_map_filename);
+    std::string sourcePath = mPath+g_map_filename;
+    std::string cachePath = sourcePath+g_cache_suffix;
+    if (loadCache(map, sourcePath, cachePath)) return;
+
+    File fr(sourcePath);
     if (!fr.isOpen()) return;
-    std::string name, devName;
+    StringRef name, devName;
+    std::string lowerName;
 
     while (fr.nextLine())
     {
         if (!fr.nextWord(name)) continue;
         if (!fr.nextWord(devName)) continue;
-        
-        Bind* b = map.getBinding(name, false);
-        
+
+        name.lower(lowerName);
+        Bind* b = map.getBinding(lowerName, false);
+
         // Search for any name a device can have
-        if (linear_search(mKeyboardDeviceNames, devName)) addKey(b, fr);
-        else if (linear_search(mMouseDeviceNames, devName)) addMouse(b, fr);
-        else if (linear_search(mJoyStickDeviceNames, devName)) addJoyStick(b, fr);
-        else log::log("Invalid device name: "+devName, log::Level::Error);
+        unsigned device;
+        if (!deviceNames().find(devName, device))
+        {
+            log::log(log::Level::Error, "Invalid device name: ", devName.str());
+            continue;
+        }
+
+        switch (device)
+        {
+        case DT_KEYBOARD: addKey(b, fr); break;
+        case DT_MOUSE: addMouse(b, fr); break;
+        case DT_JOYSTICK: addJoyStick(b, fr); break;
+        case DT_FILTER: addFilter(b, fr); break;
+        case DT_SEQUENCE: addSequence(b, fr); break;
+        }
     }
+
+    saveCache(map, sourcePath, cachePath);
 }
 
 
-void SimpleSerializer::addKey(Bind* b, File& fr) const
+bool SimpleSerializer::loadCache(NamedBindingMap& map, const std::string& sourcePath, const std::string& cachePath)
+{
+    int64_t sourceTime;
+    uint64_t sourceSize;
+    if (!file_stat(sourcePath, sourceTime, sourceSize)) return false;
+
+    MappedFile f(cachePath);
+    CacheHeader header;
+    if (f.size < sizeof(header)) return false;
+    memcpy(&header, f.data, sizeof(header));
+
+    const char* payload = f.data + sizeof(header);
+    size_t payloadSize = f.size - sizeof(header);
+
+    if (memcmp(header.magic, g_cache_magic, sizeof(header.magic)) ||
+        header.version != CacheVersion ||
+        header.byteOrder != g_cache_byte_order ||
+        header.sourceTime != sourceTime ||
+        header.sourceSize != sourceSize)
+    {
+        log::log(log::Level::Info, "Binding cache outdated: ", cachePath);
+        return false;
+    }
+
+    if (header.checksum != cache_checksum(payload, payloadSize))
+    {
+        log::log(log::Level::Warning, "Binding cache corrupted: ", cachePath);
+        return false;
+    }
+
+    CacheReader r(payload, payloadSize);
+    std::string name;
+
+    for (uint32_t i = 0; i < header.bindingCount; i++)
+    {
+        // Checksum matched, only an invalid binding count could get here.
+        // The text file is parsed into the same map, drop what was read.
+        Bind* b = r.readString(name) ? map.getBinding(name, false) : nullptr;
+        if (!b ||
+            !r.readEvents(b, &Bind::addKeyEvent) ||
+            !r.readEvents(b, &Bind::addMouseEvent) ||
+            !r.readEvents(b, &Bind::addJoyStickEvent) ||
+            !r.readFilters(b) ||
+            !r.readSequences(b))
+        {
+            log::log(log::Level::Error, "Binding cache truncated: ", cachePath);
+            std::vector<Bind*> list;
+            list.swap(map.list);
+            map.clear();
+            for (auto bind : list) delete bind;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void SimpleSerializer::saveCache(const NamedBindingMap& map, const std::string& sourcePath, const std::string& cachePath)
+{
+    CacheHeader header;
+    memcpy(header.magic, g_cache_magic, sizeof(header.magic));
+    header.version = CacheVersion;
+    header.byteOrder = g_cache_byte_order;
+    header.bindingCount = map.list.size();
+    header.reserved = 0;
+    if (!file_stat(sourcePath, header.sourceTime, header.sourceSize)) return;
+
+    std::string buf(sizeof(header), '\0');
+    for (auto b : map.list)
+    {
+        const std::string& name = *map.names[b->getId()];
+        cache_write(buf, (uint32_t)name.size());
+        buf.append(name);
+        cache_write_events(buf, b->getKeyEvents());
+        cache_write_events(buf, b->getMouseEvents());
+        cache_write_events(buf, b->getJoyStickEvents());
+        cache_write_filters(buf, b->getFilters());
+        cache_write_sequences(buf, b->getSequences());
+    }
+
+    header.checksum = cache_checksum(buf.data() + sizeof(header), buf.size() - sizeof(header));
+    memcpy(&buf[0], &header, sizeof(header));
+
+    if (!atomic_write_file(cachePath, buf.data(), buf.size()))
+        log::log(log::Level::Warning, "Error writing binding cache: ", cachePath);
+}
+
+
+void SimpleSerializer::addKey(Bind* b, File& fr)
 {
     // A space to delimit multiple combination
-    std::string word;
+    StringRef word;
     while (fr.nextWord(word))
     {
         unsigned mod = 0;
@@ -441,29 +1144,27 @@ void SimpleSerializer::addKey(Bind* b, File& fr) const
         bool rev = false;
 
         // Separator for key combination
-        std::vector<std::string> splits;
-        split_word('+', word, splits);
-
-        for (std::string& keyName : splits)
+        StringRef keyName;
+        while (!word.empty())
         {
+            word.split('+', keyName, word);
             if (is_negative(keyName)) rev = true;
 
-            auto kmnIt = mKeyModifierNames.find(keyName);
-            if (kmnIt != mKeyModifierNames.end())
+            unsigned value;
+            if (keyModifierNames().find(keyName, value))
             {
-                KeyEvent::addModifier(mod, kmnIt->second);
+                KeyEvent::addModifier(mod, value);
                 continue;
             }
 
-            auto knIt = mKeyNames.find(keyName);
-            if (knIt != mKeyNames.end())
+            if (keyNames().find(keyName, value))
             {
                 // Only one key can be binded
-                key = knIt->second;
+                key = value;
                 continue;
             }
 
-            log::log("Invalid key name:"+keyName, log::Level::Error);
+            log::log(log::Level::Error, "Invalid key name:", keyName.str());
         }
 
         b->addKeyEvent(KeyEvent::create(key, mod, rev));
@@ -471,27 +1172,27 @@ void SimpleSerializer::addKey(Bind* b, File& fr) const
 }
 
 
-void SimpleSerializer::addMouse(Bind* b, File& f) const
+void SimpleSerializer::addMouse(Bind* b, File& f)
 {
     // A space to delimit multiple combination
-    std::string word;
+    StringRef word;
     while (f.nextWord(word))
     {
         bool rev = is_negative(word);
 
-        auto it = mMouseComponentNames.find(word);
-        if (it == mMouseComponentNames.end())
+        unsigned component;
+        if (!mouseComponentNames().find(word, component))
         {
-            log::log("Invalid mouse event name: "+word, log::Level::Warning);
+            log::log(log::Level::Warning, "Invalid mouse event name: ", word.str());
             continue;
         }
 
-        b->addMouseEvent(MouseEvent::create(it->second, rev));
+        b->addMouseEvent(MouseEvent::create(component, rev));
     }
 }
 
 
-void SimpleSerializer::addJoyStick(Bind* b, File& f) const
+void SimpleSerializer::addJoyStick(Bind* b, File& f)
 {
     // Only one binding per line
     // Format: [joystick number] [component] [component id]
@@ -499,61 +1200,187 @@ void SimpleSerializer::addJoyStick(Bind* b, File& f) const
     int joystickNum;
     if (!f.nextNumber(joystickNum))
     {
-        log::log("Invalid joystick number\n", log::Level::Warning);
+        log::log(log::Level::Warning, "Invalid joystick number\n");
         return;
     }
 
-    std::string componentName;
-    if (!f.nextWord(componentName)) 
+    StringRef componentName;
+    if (!f.nextWord(componentName))
     {
-        log::log("Invalid joystick event: "+componentName, log::Level::Warning);
+        log::log(log::Level::Warning, "Invalid joystick event: ", componentName.str());
         return;
     }
 
     bool rev = is_negative(componentName);
 
-    auto cpntIt = mJoyStickComponentNames.find(componentName);
-    if (cpntIt == mJoyStickComponentNames.end())
+    unsigned component;
+    if (!joyStickComponentNames().find(componentName, component))
     {
-        log::log("Invalid joystick component: "+componentName, log::Level::Warning);
+        log::log(log::Level::Warning, "Invalid joystick component: ", componentName.str());
         return;
     }
 
     int componentId;
     if (!f.nextNumber(componentId))
     {
-        log::log("Invalid joystick component id", log::Level::Warning);
+        log::log(log::Level::Warning, "Invalid joystick component id");
+        return;
+    }
+
+    b->addJoyStickEvent(JoyStickEvent::create(component, componentId, joystickNum, rev));
+}
+
+
+void SimpleSerializer::addFilter(Bind* b, File& f)
+{
+    // One stage per line, applied in the order of the lines
+    // Format: [stage] [a] [b]
+
+    StringRef stageName;
+    unsigned type;
+    if (!f.nextWord(stageName) || !filterNames().find(stageName, type))
+    {
+        log::log(log::Level::Warning, "Invalid filter stage: ", stageName.str());
+        return;
+    }
+
+    float a, c = 0.f;
+    if (!f.nextFloat(a))
+    {
+        log::log(log::Level::Warning, "Invalid filter parameter: ", stageName.str());
+        return;
+    }
+    f.nextFloat(c); // Optional
+
+    b->addFilter(FilterStage::create(type, a, c));
+}
+
+
+void SimpleSerializer::addSequence(Bind* b, File& f)
+{
+    // Bindings pressed in order, a plus sign '+' join the bindings of a chord
+    // Format: [window ms] [step] [step] ...
+
+    int window;
+    if (!f.nextNumber(window) || window < 0)
+    {
+        log::log(log::Level::Warning, "Invalid sequence window");
         return;
     }
 
-    b->addJoyStickEvent(JoyStickEvent::create(cpntIt->second, componentId, joystickNum, rev));
+    BindSequence sequence(window);
+    StringRef word, name;
+    std::string lowerName;
+    while (f.nextWord(word))
+    {
+        sequence.steps.push_back(BindSequence::Step());
+        while (!word.empty())
+        {
+            word.split('+', name, word);
+            if (name.empty()) continue;
+            name.lower(lowerName);
+            sequence.steps.back().push_back(lowerName);
+        }
+    }
+
+    if (sequence.steps.empty())
+    {
+        log::log(log::Level::Warning, "Sequence without step");
+        return;
+    }
+    b->addSequence(sequence);
 }
 
 
 void SimpleSerializer::saveBinding(const NamedBindingMap& bs)
 {
-    File f(mPath+g_map_filename);
+    std::string sourcePath = mPath+g_map_filename;
+
+    size_t eventCount = 0;
+    for (auto b : bs.list)
+        eventCount += b->getKeyEvents().size() + b->getMouseEvents().size() + b->getJoyStickEvents().size();
+
+    File f(sourcePath, File::M_Write);
+    f.reserve(eventCount * 48);
+
     for (auto& pair : bs.map)
     {
         const std::string& name = pair.first;
         Bind* b = pair.second;
 
         for (auto& evt : b->getKeyEvents())
-            f << name << " keyboard " << keyEventToString(evt) << '\n';;
+        {
+            f << name << " keyboard ";
+            writeKeyEvent(f, evt);
+            f << '\n';
+        }
         for (auto& evt : b->getMouseEvents())
-            f << name << " mouse " << mouseEventToString(evt) << '\n';
+        {
+            f << name << " mouse ";
+            writeMouseEvent(f, evt);
+            f << '\n';
+        }
         for (auto& evt : b->getJoyStickEvents())
-            f << name << " joystick " << joyStickEventToString(evt) << '\n';
+        {
+            f << name << " joystick ";
+            writeJoyStickEvent(f, evt);
+            f << '\n';
+        }
+        for (auto& stage : b->getFilters())
+        {
+            f << name << " filter " << enum_to_string(filterNames(), stage.type) << ' ' << stage.a;
+            if (stage.b != 0.f) f << ' ' << stage.b;
+            f << '\n';
+        }
+        for (auto& sequence : b->getSequences())
+        {
+            f << name << " sequence " << sequence.window;
+            for (auto& step : sequence.steps)
+            {
+                for (unsigned i = 0; i < step.size(); i++) f << (i ? '+' : ' ') << step[i];
+            }
+            f << '\n';
+        }
     }
+
+    // Cache the map just written so the next load doesn't parse it
+    if (f.commit()) saveCache(bs, sourcePath, sourcePath+g_cache_suffix);
 }
 
 
 void SimpleSerializer::doConfig(Handler::Configuration* c, File::KeyValueOperation oper)
 {
-    File file(mPath+g_conf_filename);
+    File file(mPath+g_conf_filename, oper == File::KVO_Write ? File::M_Write : File::M_Read);
     file.keyValuePair("mouse_sensivity_axis_x", c->mouseSensivityAxisX, oper);
     file.keyValuePair("mouse_sensivity_axis_y", c->mouseSensivityAxisY, oper);
     file.keyValuePair("mouse_sensivity_axis_z", c->mouseSensivityAxisZ, oper);
+    file.optionalKeyValuePair("mouse_coalesce", c->mouseCoalesce, oper);
+    file.keyValuePair("mouse_smoothing", c->mouseSmoothing, oper);
+    file.optionalKeyValuePair("joystick_dead_zone", c->joystickAxisFilter.deadZone, oper);
+    file.optionalKeyValuePair("joystick_threshold", c->joystickAxisFilter.threshold, oper);
+    file.optionalKeyValuePair("joystick_batch_axes", c->joystickBatchAxes, oper);
+
+    std::string filters;
+    if (oper == File::KVO_Write)
+    {
+        file.writeKeyValuePair("joystick_axis_filters", axis_filters_to_string(c->joystickAxisFilters));
+    }
+    else if (file.hasKey("joystick_axis_filters"))
+    {
+        c->joystickAxisFilters.clear();
+        if (file.readKeyValuePair("joystick_axis_filters", filters) &&
+            !axis_filters_from_string(filters, c->joystickAxisFilters))
+            log::log(log::Level::Error, "File: ", mPath, g_conf_filename, " Invalid joystick_axis_filters: ", filters);
+    }
+}
+
+
+std::vector<std::string> SimpleSerializer::getFiles() const
+{
+    std::vector<std::string> files;
+    files.push_back(mPath+g_map_filename);
+    files.push_back(mPath+g_conf_filename);
+    return files;
 }
 
 
@@ -569,41 +1396,30 @@ void SimpleSerializer::saveConfig(Handler::Configuration* c)
 }
 
 
-std::string SimpleSerializer::keyEventToString(const InputEvent::Type& evt)
+void SimpleSerializer::writeKeyEvent(File& f, const InputEvent::Type& evt)
 {
-    std::stringstream ss;
-    if (InputEvent::getReverse(evt)) ss << '-';
+    if (InputEvent::getReverse(evt)) f << '-';
 
     unsigned mod = KeyEvent::getModifier(evt);
-    if (mod & OIS::Keyboard::Alt) ss << enum_to_string(mKeyModifierNames, OIS::Keyboard::Alt) << '+';
-    if (mod & OIS::Keyboard::Ctrl) ss << enum_to_string(mKeyModifierNames, OIS::Keyboard::Ctrl) << '+';
-    if (mod & OIS::Keyboard::Shift) ss << enum_to_string(mKeyModifierNames, OIS::Keyboard::Shift) << '+';
+    if (mod & OIS::Keyboard::Alt) f << enum_to_string(keyModifierNames(), OIS::Keyboard::Alt) << '+';
+    if (mod & OIS::Keyboard::Ctrl) f << enum_to_string(keyModifierNames(), OIS::Keyboard::Ctrl) << '+';
+    if (mod & OIS::Keyboard::Shift) f << enum_to_string(keyModifierNames(), OIS::Keyboard::Shift) << '+';
 
-    ss << enum_to_string(mKeyNames, KeyEvent::getKey(evt));
-
-    return ss.str();
+    f << enum_to_string(keyNames(), KeyEvent::getKey(evt));
 }
 
 
-std::string SimpleSerializer::mouseEventToString(const InputEvent::Type& evt)
+void SimpleSerializer::writeMouseEvent(File& f, const InputEvent::Type& evt)
 {
-    std::stringstream ss;
-
-    if (InputEvent::getReverse(evt)) ss << '-';
-    ss << enum_to_string(mMouseComponentNames, MouseEvent::getComponent(evt));
-
-    return ss.str();
+    if (InputEvent::getReverse(evt)) f << '-';
+    f << enum_to_string(mouseComponentNames(), MouseEvent::getComponent(evt));
 }
 
 
-std::string SimpleSerializer::joyStickEventToString(const InputEvent::Type& evt)
+void SimpleSerializer::writeJoyStickEvent(File& f, const InputEvent::Type& evt)
 {
-    std::stringstream ss;
-
-    ss << JoyStickEvent::getJoystickNumber(evt) << ' ';
-    if (InputEvent::getReverse(evt)) ss << '-';
-    ss << enum_to_string(mJoyStickComponentNames, JoyStickEvent::getComponent(evt)) << ' ';
-    ss << JoyStickEvent::getComponentId(evt);
-
-    return ss.str();
+    f << JoyStickEvent::getJoystickNumber(evt) << ' ';
+    if (InputEvent::getReverse(evt)) f << '-';
+    f << enum_to_string(joyStickComponentNames(), JoyStickEvent::getComponent(evt)) << ' ';
+    f << JoyStickEvent::getComponentId(evt);
 }
@@ -3,8 +3,10 @@
 
 #include "OISMHandler.h"
 
+#include <cstdint>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <vector>
 
 
@@ -12,21 +14,88 @@ namespace oism
 {
 
 
-typedef std::unordered_map<std::string, unsigned> NamedEnum;
+struct MappedFile;
+struct StringRef;
+
+
+//! Static entry of a 'NameTable'
+struct NamedValue
+{
+    const char* name; //!< Lowercase
+    unsigned value;
+};
+
+
+//! Immutable bidirectional table of names over a static array.
+//! Names are found through a perfect hash built once, values are mapped back
+//! to their name with a direct array.
+class NameTable
+{
+public:
+    template <size_t N>
+    NameTable(const NamedValue (&entries)[N]) : mEntries(entries), mCount(N) {build();}
+
+    /// Case-insensitive, return false if not found
+    bool find(const StringRef& name, unsigned& value) const;
+    /// Return null if the value has no name
+    const char* name(unsigned value) const
+    {
+        return value < mNames.size() ? mNames[value] : nullptr;
+    }
+
+private:
+    void build();
+    unsigned slot(const char* str, size_t size) const;
+
+    const NamedValue* mEntries;
+    unsigned mCount;
+    uint32_t mSeed;
+    unsigned mMask;
+    std::vector<unsigned short> mSlots; //!< Entry index + 1, 0 if empty
+    std::vector<const char*> mNames; //!< Indexed by value
+};
+
+
+//! Non-owning view of characters, eg. a token in a file buffer
+struct StringRef
+{
+    StringRef() : data(nullptr), size(0) {}
+    StringRef(const char* d, size_t s) : data(d), size(s) {}
+
+    bool empty() const { return !size; }
+    std::string str() const { return std::string(data, size); }
+    void lower(std::string& out) const; //!< Lowercase copy, reuse 'out' capacity
+    bool iequals(const char* other) const; //!< Case-insensitive
+
+    /// Split at the first 'token', 'rest' is empty if not found
+    void split(char token, StringRef& head, StringRef& rest) const;
+
+    const char* data;
+    size_t size;
+};
 
 
 struct File
 {
-    File(const std::string& filename);
+    enum Mode
+    {
+        M_Read,  //!< Whole file is mapped, tokens point into it
+        M_Write  //!< File is truncated
+    };
+
+    File(const std::string& filename, Mode mode = M_Read);
+    ~File();
     bool isOpen();
 
-    // Return length
-    int nextWord(std::string& str);
-    int nextNumber(int& num);
-    int nextLine();
+    // Return false at the end of the file/line
+    bool nextLine();
+    bool nextWord(StringRef& str);
+    bool nextNumber(int& num);
+    bool nextFloat(float& num);
 
     bool readKeyValuePair(const std::string& key, int& value);
     bool readKeyValuePair(const std::string& key, float& value);
+    bool readKeyValuePair(const std::string& key, bool& value);
     bool readKeyValuePair(const std::string& key, std::string& value);
 
     enum KeyValueOperation
@@ -42,26 +111,62 @@ struct File
         else readKeyValuePair(key, value);
     }
 
+    /// Keys added after a file was written, 'value' is kept if missing
     template <class T>
-    void writeKeyValuePair(const std::string& key, const T& value)
+    void optionalKeyValuePair(const std::string& key, T& value, KeyValueOperation oper)
     {
-        fs << key << ' ' << value << std::endl;
+        if (oper == KVO_Write) writeKeyValuePair(key, value);
+        else if (hasKey(key)) readKeyValuePair(key, value);
     }
 
-    std::string _findKey(const std::string& key);
+    bool hasKey(const std::string& key);
+
+    template <class T>
+    void writeKeyValuePair(const std::string& key, const T& value)
+    {
+        write(key);
+        write(' ');
+        write(value);
+        write('\n');
+    }
 
-    std::fstream fs;
-    std::string line;
+    /// @name Writing
+    /// Text is buffered and replace the file atomically on 'commit()' or destruction
+    ///@{
+    void reserve(size_t size) { out.reserve(size); }
+    void write(const std::string& str) { out.append(str); }
+    void write(const char* str) { out.append(str); }
+    void write(char c) { out.push_back(c); }
+    void write(int n);
+    void write(unsigned n);
+    void write(float f);
+    bool commit(); //!< Return false if the file couldn't be replaced
+    ///@}
+
+    /// Value of a config key, keys are indexed on first use in a single pass
+    StringRef _findKey(const std::string& key);
+    void _indexKeys();
+
+    std::string out; //!< Write buffer
+    bool pendingWrite;
+    std::unique_ptr<MappedFile> mapped;
     std::string filename;
-    size_t wend;
     size_t lineNum;
+
+    // Reading position
+    const char* pos;
+    const char* end;
+    const char* lineEnd;
+
+    std::unordered_map<std::string, StringRef> keys; //!< Lowercase config keys
+    bool keysIndexed;
 };
 
 
 template <class T>
 inline File& operator<<(File& file, const T& t)
 {
-    file.fs << t;
+    file.write(t);
     return file;
 }
 
@@ -75,27 +180,51 @@ public:
     virtual void loadConfig(Handler::Configuration*);
     virtual void saveBinding(const NamedBindingMap&);
     virtual void saveConfig(Handler::Configuration*);
+    virtual std::vector<std::string> getFiles() const;
+
+    /// @name Binary cache of the map file
+    /// Written next to the map file after parsing it, used instead of the
+    /// text file until its modification time or size changes.
+    ///@{
+    static const unsigned CacheVersion = 3;
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t checksum; //!< FNV-1a of everything after the header
+        int64_t sourceTime;
+        uint64_t sourceSize;
+        uint32_t bindingCount;
+        uint32_t reserved;
+    };
+    bool loadCache(NamedBindingMap&, const std::string& sourcePath, const std::string& cachePath);
+    void saveCache(const NamedBindingMap&, const std::string& sourcePath, const std::string& cachePath);
+    ///@}
 
 protected:
-    void addKey(Bind* b, File& fr) const;
-    void addMouse(Bind* b, File& fr) const;
-    void addJoyStick(Bind* b, File& fr) const;
-
-    std::string keyEventToString(const InputEvent::Type& evt);
-    std::string mouseEventToString(const InputEvent::Type& evt);
-    std::string joyStickEventToString(const InputEvent::Type& evt);
+    void addKey(Bind* b, File& fr);
+    void addMouse(Bind* b, File& fr);
+    void addJoyStick(Bind* b, File& fr);
+    void addFilter(Bind* b, File& fr);
+    void addSequence(Bind* b, File& fr);
+
+    /// @name Tables shared by every serializer, built on first use
+    ///@{
+    static const NameTable& keyNames();
+    static const NameTable& keyModifierNames();
+    static const NameTable& mouseComponentNames();
+    static const NameTable& joyStickComponentNames();
+    static const NameTable& filterNames();
+    static const NameTable& deviceNames(); //!< Devices can have aliases
+    ///@}
+
+    void writeKeyEvent(File& f, const InputEvent::Type& evt);
+    void writeMouseEvent(File& f, const InputEvent::Type& evt);
+    void writeJoyStickEvent(File& f, const InputEvent::Type& evt);
 
     void doConfig(Handler::Configuration* c, File::KeyValueOperation oper);
 
-    NamedEnum mKeyNames;
-    NamedEnum mKeyModifierNames;
-    NamedEnum mMouseComponentNames;
-    NamedEnum mJoyStickComponentNames;
-
-    // Devices can have aliases
-    std::vector<std::string> mKeyboardDeviceNames;
-    std::vector<std::string> mMouseDeviceNames;
-    std::vector<std::string> mJoyStickDeviceNames;
 };
 
 
@@ -0,0 +1,311 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#include "OISMSyntheticBackend.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+using namespace oism;
+
+
+/*
+=====================
+SyntheticKeyboard
+=====================
+*/
+
+
+SyntheticKeyboard::SyntheticKeyboard(int id)
+:   OIS::Keyboard("Synthetic", true, id, nullptr)
+{
+    std::memset(mKeys, 0, sizeof(mKeys));
+}
+
+
+const std::string& SyntheticKeyboard::getAsString(OIS::KeyCode key)
+{
+    mKeyName = "Key" + std::to_string((unsigned)key);
+    return mKeyName;
+}
+
+
+void SyntheticKeyboard::copyKeyStates(char keys[256]) const
+{
+    for (unsigned i = 0; i < 256; i++) keys[i] = mKeys[i];
+}
+
+
+void SyntheticKeyboard::capture()
+{
+    // Listeners may queue more events, dispatched in the same capture
+    for (size_t i = 0; i < mEvents.size(); i++)
+    {
+        Event evt = mEvents[i];
+        mKeys[evt.key & 0xff] = evt.pressed;
+
+        unsigned mod = 0;
+        switch (evt.key)
+        {
+            case OIS::KC_LSHIFT: case OIS::KC_RSHIFT: mod = Shift; break;
+            case OIS::KC_LCONTROL: case OIS::KC_RCONTROL: mod = Ctrl; break;
+            case OIS::KC_LMENU: case OIS::KC_RMENU: mod = Alt; break;
+            default: break;
+        }
+        if (evt.pressed) mModifiers |= mod;
+        else mModifiers &= ~mod;
+
+        if (!mListener) continue;
+        if (evt.pressed) mListener->keyPressed(OIS::KeyEvent(this, evt.key, 0));
+        else mListener->keyReleased(OIS::KeyEvent(this, evt.key, 0));
+    }
+    mEvents.clear();
+}
+
+
+/*
+=====================
+SyntheticMouse
+=====================
+*/
+
+
+SyntheticMouse::SyntheticMouse(int id)
+:   OIS::Mouse("Synthetic", true, id, nullptr)
+{
+}
+
+
+void SyntheticMouse::capture()
+{
+    for (size_t i = 0; i < mEvents.size(); i++)
+    {
+        Event evt = mEvents[i];
+        switch (evt.type)
+        {
+            case EV_MOVE:
+                mState.X.rel = evt.x;
+                mState.Y.rel = evt.y;
+                mState.Z.rel = evt.z;
+                mState.X.abs = std::max(0, std::min(mState.width, mState.X.abs + evt.x));
+                mState.Y.abs = std::max(0, std::min(mState.height, mState.Y.abs + evt.y));
+                mState.Z.abs += evt.z;
+                if (mListener) mListener->mouseMoved(OIS::MouseEvent(this, mState));
+                break;
+            case EV_PRESS:
+                mState.buttons |= 1 << evt.x;
+                if (mListener) mListener->mousePressed(OIS::MouseEvent(this, mState), (OIS::MouseButtonID)evt.x);
+                break;
+            case EV_RELEASE:
+                mState.buttons &= ~(1 << evt.x);
+                if (mListener) mListener->mouseReleased(OIS::MouseEvent(this, mState), (OIS::MouseButtonID)evt.x);
+                break;
+        }
+    }
+    mEvents.clear();
+
+    mState.X.rel = mState.Y.rel = mState.Z.rel = 0;
+}
+
+
+/*
+=====================
+SyntheticJoyStick
+=====================
+*/
+
+
+SyntheticJoyStick::SyntheticJoyStick(int id, unsigned buttons, unsigned axes, unsigned povs,
+                                     const std::string& vendor/* = "Synthetic"*/)
+:   OIS::JoyStick(vendor, true, id, nullptr)
+{
+    mState.mButtons.resize(buttons, false);
+    mState.mAxes.resize(axes);
+    mPOVs = std::min(povs, 4u);
+}
+
+
+void SyntheticJoyStick::capture()
+{
+    for (size_t i = 0; i < mEvents.size(); i++)
+    {
+        Event evt = mEvents[i];
+        OIS::JoyStickEvent arg(this, mState);
+        switch (evt.type)
+        {
+            case EV_PRESS:
+            case EV_RELEASE:
+                if (evt.component >= mState.mButtons.size()) break;
+                mState.mButtons[evt.component] = evt.type == EV_PRESS;
+                if (!mListener) break;
+                if (evt.type == EV_PRESS) mListener->buttonPressed(arg, evt.component);
+                else mListener->buttonReleased(arg, evt.component);
+                break;
+            case EV_AXIS:
+                if (evt.component >= mState.mAxes.size()) break;
+                mState.mAxes[evt.component].abs = evt.value;
+                if (mListener) mListener->axisMoved(arg, evt.component);
+                break;
+            case EV_POV:
+                if (evt.component >= (unsigned)mPOVs) break;
+                mState.mPOV[evt.component].direction = evt.value;
+                if (mListener) mListener->povMoved(arg, evt.component);
+                break;
+        }
+    }
+    mEvents.clear();
+}
+
+
+/*
+=====================
+SyntheticBackend
+=====================
+*/
+
+
+SyntheticBackend::SyntheticBackend(unsigned joySticks/* = 0*/, unsigned buttons/* = 16*/,
+                                   unsigned axes/* = 8*/, unsigned povs/* = 1*/)
+:   mJoyStickCount(joySticks),
+    mButtonCount(buttons),
+    mAxisCount(axes),
+    mPovCount(povs),
+    mKeyboard(nullptr),
+    mMouse(nullptr),
+    mConnected(joySticks, "Synthetic")
+{
+}
+
+
+DeviceSet SyntheticBackend::create(unsigned long windowID, bool exclusive, bool verbose, bool joySticks)
+{
+    DeviceSet devices;
+    devices.exclusive = exclusive;
+    SyntheticKeyboard* keyboard = new SyntheticKeyboard(0);
+    SyntheticMouse* mouse = new SyntheticMouse(0);
+    std::vector<SyntheticJoyStick*> sticks;
+    for (unsigned i = 0; joySticks && i < mJoyStickCount; i++)
+        sticks.push_back(new SyntheticJoyStick(i, mButtonCount, mAxisCount, mPovCount));
+
+    devices.keyboard = keyboard;
+    devices.mouse = mouse;
+    devices.joySticks.assign(sticks.begin(), sticks.end());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mKeyboard = keyboard;
+    mMouse = mouse;
+    if (joySticks) mJoySticks = sticks;
+    return devices;
+}
+
+
+void SyntheticBackend::destroy(DeviceSet& devices)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (devices.keyboard == mKeyboard) mKeyboard = nullptr;
+        if (devices.mouse == mMouse) mMouse = nullptr;
+        for (auto js : devices.joySticks)
+            std::replace(mJoySticks.begin(), mJoySticks.end(), static_cast<SyntheticJoyStick*>(js),
+                         (SyntheticJoyStick*)nullptr);
+    }
+
+    delete devices.keyboard;
+    delete devices.mouse;
+    for (auto js : devices.joySticks) delete js;
+    devices = DeviceSet();
+}
+
+
+SyntheticKeyboard* SyntheticBackend::getKeyboard()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mKeyboard;
+}
+
+
+SyntheticMouse* SyntheticBackend::getMouse()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMouse;
+}
+
+
+SyntheticJoyStick* SyntheticBackend::getJoyStick(unsigned joystick)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return joystick < mJoySticks.size() ? mJoySticks[joystick] : nullptr;
+}
+
+
+SyntheticJoyStick* SyntheticBackend::getJoyStick(const std::string& identity)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mHotplugged.find(identity);
+    return it != mHotplugged.end() ? it->second : nullptr;
+}
+
+
+void SyntheticBackend::connectJoyStick(const std::string& vendor/* = "Synthetic"*/)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mConnected.push_back(vendor);
+}
+
+
+void SyntheticBackend::disconnectJoyStick(const std::string& identity)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::string> identities = makeJoyStickIdentities(mConnected);
+    auto it = std::find(identities.begin(), identities.end(), identity);
+    if (it != identities.end()) mConnected.erase(mConnected.begin() + (it - identities.begin()));
+}
+
+
+bool SyntheticBackend::listJoySticks(unsigned long windowID, std::vector<std::string>& identities)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    identities = makeJoyStickIdentities(mConnected);
+    return true;
+}
+
+
+std::vector<OIS::JoyStick*> SyntheticBackend::createJoySticks(unsigned long windowID,
+                                                              const std::vector<std::string>& identities)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::string> connected = makeJoyStickIdentities(mConnected);
+
+    std::vector<OIS::JoyStick*> joySticks;
+    for (auto& identity : identities)
+    {
+        auto it = std::find(connected.begin(), connected.end(), identity);
+        if (it == connected.end())
+        {
+            joySticks.push_back(nullptr);
+            continue;
+        }
+
+        const std::string& vendor = mConnected[it - connected.begin()];
+        auto js = new SyntheticJoyStick(it - connected.begin(), mButtonCount, mAxisCount, mPovCount, vendor);
+        mHotplugged[identity] = js;
+        joySticks.push_back(js);
+    }
+    return joySticks;
+}
+
+
+void SyntheticBackend::destroyJoyStick(OIS::JoyStick* joystick)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto it = mHotplugged.begin(); it != mHotplugged.end(); ++it)
+        {
+            if (it->second != joystick) continue;
+            mHotplugged.erase(it);
+            break;
+        }
+    }
+    delete joystick;
+}
@@ -0,0 +1,160 @@
+// Licensed under the zlib License
+// Copyright (C) 2012 Sebastien Raymond
+
+#pragma once
+
+#include "OISMDeviceBackend.h"
+
+#include <OISJoyStick.h>
+#include <OISKeyboard.h>
+#include <OISMouse.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace oism
+{
+
+
+/// @name Synthetic devices
+/// Events are queued by the script and dispatched to the listener on the next
+/// 'capture()', like buffered OIS devices. Not thread safe, script them on the
+/// dispatching thread or between 'update()' calls.
+///@{
+class SyntheticKeyboard : public OIS::Keyboard
+{
+public:
+    SyntheticKeyboard(int id);
+
+    void press(OIS::KeyCode key) { mEvents.push_back(Event{key, true}); }
+    void release(OIS::KeyCode key) { mEvents.push_back(Event{key, false}); }
+
+    // OIS::Keyboard
+    bool isKeyDown(OIS::KeyCode key) const { return mKeys[key & 0xff]; }
+    const std::string& getAsString(OIS::KeyCode key);
+    void copyKeyStates(char keys[256]) const;
+    void setBuffered(bool) {}
+    void capture(); //!< Modifiers are updated before the listener is called, like OIS
+    OIS::Interface* queryInterface(OIS::Interface::IType) { return nullptr; }
+    void _initialize() {}
+
+private:
+    struct Event
+    {
+        OIS::KeyCode key;
+        bool pressed;
+    };
+
+    std::vector<Event> mEvents;
+    bool mKeys[256];
+    std::string mKeyName;
+};
+
+
+class SyntheticMouse : public OIS::Mouse
+{
+public:
+    SyntheticMouse(int id);
+
+    void move(int relX, int relY, int relZ = 0) { mEvents.push_back(Event{EV_MOVE, relX, relY, relZ}); }
+    void press(OIS::MouseButtonID button) { mEvents.push_back(Event{EV_PRESS, button, 0, 0}); }
+    void release(OIS::MouseButtonID button) { mEvents.push_back(Event{EV_RELEASE, button, 0, 0}); }
+
+    // OIS::Mouse
+    void setBuffered(bool) {}
+    void capture(); //!< One 'mouseMoved()' per move, absolute position clamped to the limit
+    OIS::Interface* queryInterface(OIS::Interface::IType) { return nullptr; }
+    void _initialize() {}
+
+private:
+    enum EventType { EV_MOVE, EV_PRESS, EV_RELEASE };
+    struct Event
+    {
+        EventType type;
+        int x, y, z; //!< Button in 'x'
+    };
+
+    std::vector<Event> mEvents;
+};
+
+
+class SyntheticJoyStick : public OIS::JoyStick
+{
+public:
+    SyntheticJoyStick(int id, unsigned buttons, unsigned axes, unsigned povs, const std::string& vendor = "Synthetic");
+
+    void press(unsigned button) { mEvents.push_back(Event{EV_PRESS, button, 0}); }
+    void release(unsigned button) { mEvents.push_back(Event{EV_RELEASE, button, 0}); }
+    void moveAxis(unsigned axis, int value) { mEvents.push_back(Event{EV_AXIS, axis, value}); }
+    void movePov(unsigned idx, int direction) { mEvents.push_back(Event{EV_POV, idx, direction}); }
+
+    // OIS::JoyStick
+    void setBuffered(bool) {}
+    void capture(); //!< Out of range components are ignored
+    OIS::Interface* queryInterface(OIS::Interface::IType) { return nullptr; }
+    void _initialize() {}
+
+private:
+    enum EventType { EV_PRESS, EV_RELEASE, EV_AXIS, EV_POV };
+    struct Event
+    {
+        EventType type;
+        unsigned component;
+        int value;
+    };
+
+    std::vector<Event> mEvents;
+};
+///@}
+
+
+//! Scripted keyboard, mouse and joysticks, no input system or window needed.
+//! Makes handlers testable and benchmarkable headless, devices are recreated
+//! like OIS ones on exclusive mode switches, events queued on them are lost.
+class SyntheticBackend : public DeviceBackend
+{
+public:
+    SyntheticBackend(unsigned joySticks = 0, unsigned buttons = 16, unsigned axes = 8, unsigned povs = 1);
+
+    DeviceSet create(unsigned long windowID, bool exclusive, bool verbose, bool joySticks);
+    void destroy(DeviceSet& devices);
+
+    /// @name Latest created devices
+    ///@{
+    SyntheticKeyboard* getKeyboard();
+    SyntheticMouse* getMouse();
+    SyntheticJoyStick* getJoyStick(unsigned joystick); //!< Null if out of range
+    SyntheticJoyStick* getJoyStick(const std::string& identity); //!< Created by hotplug, null if none
+    ///@}
+
+    /// @name Joystick hotplug
+    /// The joysticks given to the constructor are connected as "Synthetic".
+    /// Scripted from any thread, seen on the next scan.
+    ///@{
+    void connectJoyStick(const std::string& vendor = "Synthetic");
+    void disconnectJoyStick(const std::string& identity); //!< Next ones of its vendor are renumbered
+
+    bool listJoySticks(unsigned long windowID, std::vector<std::string>& identities);
+    std::vector<OIS::JoyStick*> createJoySticks(unsigned long windowID, const std::vector<std::string>& identities);
+    void destroyJoyStick(OIS::JoyStick* joystick);
+    ///@}
+
+private:
+    unsigned mJoyStickCount;
+    unsigned mButtonCount;
+    unsigned mAxisCount;
+    unsigned mPovCount;
+
+    std::mutex mMutex; //!< Devices can be created on any thread
+    SyntheticKeyboard* mKeyboard;
+    SyntheticMouse* mMouse;
+    std::vector<SyntheticJoyStick*> mJoySticks;
+    std::vector<std::string> mConnected; //!< Vendors, in enumeration order
+    std::unordered_map<std::string, SyntheticJoyStick*> mHotplugged; //!< By identity
+};
+
+
+} // namespace oism
@@ -3,8 +3,16 @@
 namespace oism
 {
     class Bind;
+    class CallbackHandle;
     class CallbackList;
+    class CallbackRegistry;
+    class DeviceBackend;
+    class FileWatcher;
     class Handler;
+    class InputThread;
+    class JoyStickHotplug;
+    class Player;
+    class Recorder;
     class Serializer;
     class JoyStickListener;
 } // namespace oism
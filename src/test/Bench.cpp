@@ -0,0 +1,449 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+#include "../OISMSyntheticBackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// Count allocations of the whole program, array forms use these
+std::atomic<unsigned long long> g_allocs(0);
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+
+struct Result
+{
+    std::string name;
+    unsigned param; //!< Bindings, sources or callbacks
+    unsigned samples;
+    unsigned batch; //!< Operations per sample
+    double p50, p99, p999; //!< Nanoseconds per operation
+    double allocs; //!< Per operation
+};
+
+
+std::vector<Result> g_results;
+
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.;
+    return sorted[std::min<size_t>(sorted.size() - 1, sorted.size() * p)];
+}
+
+
+// Time 'batch' calls of 'op' per sample, until 'maxSamples' or the time budget is used.
+// 'opsPerCall' is the number of operations done by one call.
+template <class Op>
+void measure(const std::string& name, unsigned param, unsigned batch, Op op,
+             unsigned maxSamples = 2000, unsigned opsPerCall = 1)
+{
+    const double budget = 0.2; // Seconds
+    using namespace std::chrono;
+
+    std::vector<double> times;
+    times.reserve(maxSamples);
+    op(); // Warm up
+
+    unsigned long long allocs = g_allocs.load();
+    auto end = steady_clock::now() + duration_cast<steady_clock::duration>(duration<double>(budget));
+    while (times.size() < maxSamples && (times.size() < 5 || steady_clock::now() < end))
+    {
+        auto start = steady_clock::now();
+        for (unsigned i = 0; i < batch; i++) op();
+        times.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count() /
+                        ((double)batch * opsPerCall));
+    }
+    allocs = g_allocs.load() - allocs;
+
+    std::sort(times.begin(), times.end());
+    Result r;
+    r.name = name;
+    r.param = param;
+    r.samples = times.size();
+    r.batch = batch * opsPerCall;
+    r.p50 = percentile(times, .5);
+    r.p99 = percentile(times, .99);
+    r.p999 = percentile(times, .999);
+    r.allocs = allocs / ((double)r.samples * r.batch);
+    g_results.push_back(r);
+
+    std::printf("%-24s %7u %10.1f %10.1f %10.1f %10.3f\n", name.c_str(), param, r.p50, r.p99, r.p999, r.allocs);
+    std::fflush(stdout);
+}
+
+
+std::string bindingName(unsigned i) { return "binding" + std::to_string(i); }
+
+
+// Binding 'i' is bound to a key slot, bindings share slots past 2048
+oism::InputEvent::Type keyEvent(unsigned i)
+{
+    const unsigned slotCount = oism::KeyEvent::SlotCount;
+    unsigned slot = i % slotCount;
+    return oism::KeyEvent::create(slot / oism::KeyEvent::ModifierCount,
+        oism::KeyEvent::unpackModifier(slot % oism::KeyEvent::ModifierCount), false);
+}
+
+
+void bindKeys(oism::Handler* input, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+        input->getBinding(bindingName(i), false)->addKeyEvent(keyEvent(i));
+    input->_buildBindingListMaps();
+}
+
+
+struct SourceBind : public oism::Bind
+{
+    using oism::Bind::setValue;
+};
+
+
+void benchDispatch(unsigned n)
+{
+    oism::Handler input;
+    bindKeys(&input, n);
+    const unsigned slotCount = oism::KeyEvent::SlotCount;
+    unsigned keys = std::min(n, slotCount);
+
+    unsigned i = 0;
+    measure("dispatch_inject", n, 256, [&]()
+    {
+        oism::InputEvent::Type evt = keyEvent(i / 2 % keys);
+        input.injectKey(oism::KeyEvent::getKey(evt), oism::KeyEvent::getModifier(evt), !(i & 1));
+        ++i;
+    });
+}
+
+
+void benchDispatchDevice(unsigned n)
+{
+    auto backend = std::make_shared<oism::SyntheticBackend>();
+    oism::Handler input(backend);
+    for (unsigned i = 0; i < n; i++)
+        input.getBinding(bindingName(i), false)->addKeyEvent(oism::KeyEvent::create(i % 256, 0, false));
+    input._buildBindingListMaps();
+
+    // One sample is a capture of 256 events
+    const unsigned events = 256;
+    unsigned i = 0;
+    measure("dispatch_device", n, 1, [&]()
+    {
+        oism::SyntheticKeyboard* keyboard = backend->getKeyboard();
+        for (unsigned e = 0; e < events; e += 2, i++)
+        {
+            keyboard->press((OIS::KeyCode)(i % 256));
+            keyboard->release((OIS::KeyCode)(i % 256));
+        }
+        input.update();
+    }, 2000, events);
+}
+
+
+// 'n' bindings on the mouse axes, one sample is a capture of 64 moves
+void benchMouse(unsigned n, bool coalesce)
+{
+    auto backend = std::make_shared<oism::SyntheticBackend>();
+    oism::Handler input(backend);
+    input.getConfiguration().mouseCoalesce = coalesce;
+    for (unsigned i = 0; i < n; i++)
+    {
+        oism::Bind* b = input.getBinding(bindingName(i), false);
+        b->addMouseEvent(oism::MouseEvent::create(oism::MouseEvent::CPNT_AXIS_X));
+        b->addMouseEvent(oism::MouseEvent::create(oism::MouseEvent::CPNT_AXIS_Y));
+    }
+    input._buildBindingListMaps();
+
+    const unsigned events = 64;
+    unsigned i = 0;
+    measure(coalesce ? "mouse_coalesced" : "mouse_per_event", n, 1, [&]()
+    {
+        oism::SyntheticMouse* mouse = backend->getMouse();
+        for (unsigned e = 0; e < events; e++, i++) mouse->move(1 + i % 3, -(int)(i % 5));
+        input.update();
+    }, 2000, events);
+}
+
+
+void benchMousePerEvent(unsigned n) { benchMouse(n, false); }
+void benchMouseCoalesced(unsigned n) { benchMouse(n, true); }
+
+
+// 'n' bindings on the axes of an idle stick reporting sensor noise,
+// one sample is a capture of 256 axis events
+void benchJoyStickNoise(unsigned n, bool filtered)
+{
+    const unsigned axes = 4;
+    auto backend = std::make_shared<oism::SyntheticBackend>(1, 16, axes);
+    oism::Handler input(backend);
+    if (filtered) input.getConfiguration().joystickAxisFilter = oism::Handler::Configuration::AxisFilter(.05f, .01f);
+    for (unsigned i = 0; i < n; i++)
+        input.getBinding(bindingName(i), false)->addJoyStickEvent(oism::JoyStickEvent::create(OIS::OIS_Axis, i % axes, 0));
+    input._buildBindingListMaps();
+
+    const unsigned events = 256;
+    unsigned i = 0;
+    measure(filtered ? "joystick_noise_filtered" : "joystick_noise_raw", n, 1, [&]()
+    {
+        oism::SyntheticJoyStick* stick = backend->getJoyStick(0);
+        for (unsigned e = 0; e < events; e++, i++)
+            stick->moveAxis(i % axes, (int)((i * 2654435761u) >> 22) - 512); // Within +-512 of the center
+        input.update();
+    }, 2000, events);
+}
+
+
+void benchJoyStickRaw(unsigned n) { benchJoyStickNoise(n, false); }
+void benchJoyStickFiltered(unsigned n) { benchJoyStickNoise(n, true); }
+
+
+// 8 pads of 8 axes all moving, 'n' bindings spread on the axes. Pads report
+// 4 events per axis per capture, as when polled faster than the frame rate.
+// One sample is a capture, operations are axis events.
+void benchJoyStickAxes(unsigned n, bool batch)
+{
+    const unsigned pads = 8, axes = 8, events = 4;
+    auto backend = std::make_shared<oism::SyntheticBackend>(pads, 16, axes);
+    oism::Handler input(backend);
+    input.getConfiguration().joystickBatchAxes = batch;
+    for (unsigned i = 0; i < n; i++)
+        input.getBinding(bindingName(i), false)->addJoyStickEvent(
+            oism::JoyStickEvent::create(OIS::OIS_Axis, i % axes, i / axes % pads));
+    input._buildBindingListMaps();
+
+    unsigned frame = 0;
+    measure(batch ? "joystick_axes_batch" : "joystick_axes_per_event", n, 1, [&]()
+    {
+        for (unsigned p = 0; p < pads; p++)
+        {
+            oism::SyntheticJoyStick* stick = backend->getJoyStick(p);
+            for (unsigned e = 0; e < events; e++)
+                for (unsigned a = 0; a < axes; a++)
+                    stick->moveAxis(a, (int)(((frame * events + e) * 977 + p * 131 + a * 17) % 60000) - 30000);
+        }
+        ++frame;
+        input.update();
+    }, 2000, pads * axes * events);
+}
+
+
+void benchJoyStickPerEvent(unsigned n) { benchJoyStickAxes(n, false); }
+void benchJoyStickBatch(unsigned n) { benchJoyStickAxes(n, true); }
+
+
+// 'n' bindings on the 8 axes of a pad, each with a smoothing, curve and sensitivity chain.
+// Half the axes move every frame, the other half settle. One sample is an update.
+void benchFilters(unsigned n)
+{
+    const unsigned axes = 8;
+    auto backend = std::make_shared<oism::SyntheticBackend>(1, 16, axes);
+    oism::Handler input(backend);
+    typedef oism::FilterStage FS;
+    for (unsigned i = 0; i < n; i++)
+    {
+        oism::Bind* b = input.getBinding(bindingName(i), false);
+        b->addJoyStickEvent(oism::JoyStickEvent::create(OIS::OIS_Axis, i % axes, 0));
+        b->addFilter(FS::create(FS::FT_SMOOTH, .5f));
+        b->addFilter(FS::create(FS::FT_BEZIER, .2f, .8f));
+        b->addFilter(FS::create(FS::FT_SCALE, 1.5f));
+    }
+    input._buildBindingListMaps();
+
+    unsigned frame = 0;
+    measure("filter_update", n, 1, [&]()
+    {
+        oism::SyntheticJoyStick* stick = backend->getJoyStick(0);
+        for (unsigned a = 0; a < axes / 2; a++)
+            stick->moveAxis(a, (int)((frame * 977 + a * 17) % 60000) - 30000);
+        ++frame;
+        input.update();
+    }, 2000);
+}
+
+
+// 'n' sequences of 4 steps over 32 bindings, one operation is a press
+void benchSequences(unsigned n)
+{
+    oism::SequenceMatcher matcher;
+    for (unsigned i = 0; i < n; i++)
+    {
+        unsigned h = i * 2654435761u;
+        matcher.add(i, {{h % 32}, {(h >> 5) % 32}, {(h >> 10) % 32}, {(h >> 15) % 32}}, 200);
+    }
+    matcher.compile();
+
+    unsigned i = 0;
+    measure("sequence_press", n, 256, [&]()
+    {
+        matcher.press((i * 2654435761u) >> 27, i);
+        ++i;
+    });
+}
+
+
+void benchSetValue(unsigned n)
+{
+    SourceBind b;
+    b._resetSources(n);
+
+    unsigned i = 0;
+    measure("bind_set_value", n, 256, [&]()
+    {
+        b.setValue(i % n, (i & 1) ? 0.f : (float)(i % 7) / 7.f);
+        ++i;
+    });
+}
+
+
+void benchCallbacks(unsigned n)
+{
+    oism::Handler input;
+    oism::Bind* fire = input.getBinding("fire", false);
+    fire->addKeyEvent(oism::KeyEvent::create(OIS::KC_SPACE, 0, false));
+    input._buildBindingListMaps();
+
+    unsigned long calls = 0;
+    std::vector<oism::CallbackHandle> handles;
+    for (unsigned i = 0; i < n; i++) handles.push_back(input.callback("fire", [&calls](){++calls;}));
+
+    // Press and release, callbacks run on press
+    measure("callback_fanout", n, n > 1000 ? 1 : 64, [&]()
+    {
+        input.injectKey(OIS::KC_SPACE, 0, true);
+        input.injectKey(OIS::KC_SPACE, 0, false);
+    });
+}
+
+
+void benchUpdate(unsigned n)
+{
+    oism::Handler input;
+    bindKeys(&input, n);
+    measure("update_idle", n, 256, [&](){input.update();});
+}
+
+
+void benchBuild(unsigned n)
+{
+    oism::Handler input;
+    for (unsigned i = 0; i < n; i++)
+    {
+        oism::Bind* b = input.getBinding(bindingName(i), false);
+        b->addKeyEvent(keyEvent(i));
+        b->addMouseEvent(oism::MouseEvent::create(i % oism::MouseEvent::CPNT_COUNT));
+        b->addJoyStickEvent(oism::JoyStickEvent::create(OIS::OIS_Button, i % 32, i % 4));
+    }
+    measure("build_dispatch", n, 1, [&](){input._buildBindingListMaps();}, 200);
+}
+
+
+void benchSerializer(unsigned n)
+{
+    const std::string path = "bench-map/";
+    system(("mkdir -p "+path).c_str());
+    {
+        std::ofstream fs(path+"inputmap", std::ios::trunc);
+        for (unsigned i = 0; i < n; i++)
+            fs << bindingName(i) << "\tkeyboard w -s LShift+Up\tjoystick " << i % 4 << " axis " << i % 8 << '\n';
+    }
+    std::ofstream(path+"inputconf", std::ios::trunc);
+
+    measure("serializer_load_text", n, 1, [&]()
+    {
+        std::remove((path+"inputmap.cache").c_str());
+        oism::Handler input;
+        input.load<oism::SimpleSerializer>(path);
+    }, 100);
+
+    measure("serializer_load_cache", n, 1, [&]()
+    {
+        oism::Handler input;
+        input.load<oism::SimpleSerializer>(path);
+    }, 100);
+
+    oism::Handler input;
+    input.load<oism::SimpleSerializer>(path);
+    measure("serializer_save", n, 1, [&](){input.save<oism::SimpleSerializer>(path);}, 100);
+}
+
+
+void writeJson(const std::string& path)
+{
+    std::ofstream fs(path, std::ios::trunc);
+    fs << "{\n  \"benchmarks\": [\n";
+    for (unsigned i = 0; i < g_results.size(); i++)
+    {
+        const Result& r = g_results[i];
+        fs << "    {\"name\": \"" << r.name << "\", \"param\": " << r.param
+           << ", \"samples\": " << r.samples << ", \"batch\": " << r.batch
+           << ", \"p50_ns\": " << r.p50 << ", \"p99_ns\": " << r.p99 << ", \"p999_ns\": " << r.p999
+           << ", \"allocs_per_op\": " << r.allocs << "}" << (i + 1 < g_results.size() ? "," : "") << "\n";
+    }
+    fs << "  ]\n}\n";
+}
+
+
+// Microbenchmarks from 10 to 100k bindings, sources or callbacks, no window needed.
+// Usage: bench [--max N] [--json path] [--filter name]
+int main(int argc, char** argv)
+{
+    unsigned maxParam = 100000;
+    std::string json = "bench.json";
+    std::string filter;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--max")) maxParam = std::stoul(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--json")) json = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--filter")) filter = argv[i + 1];
+    }
+
+    typedef void (*Bench)(unsigned);
+    const std::pair<const char*, Bench> benches[] =
+    {
+        {"dispatch_inject", benchDispatch},
+        {"dispatch_device", benchDispatchDevice},
+        {"mouse_per_event", benchMousePerEvent},
+        {"mouse_coalesced", benchMouseCoalesced},
+        {"joystick_noise_raw", benchJoyStickRaw},
+        {"joystick_noise_filtered", benchJoyStickFiltered},
+        {"joystick_axes_per_event", benchJoyStickPerEvent},
+        {"joystick_axes_batch", benchJoyStickBatch},
+        {"filter_update", benchFilters},
+        {"sequence_press", benchSequences},
+        {"bind_set_value", benchSetValue},
+        {"callback_fanout", benchCallbacks},
+        {"update_idle", benchUpdate},
+        {"build_dispatch", benchBuild},
+        {"serializer", benchSerializer},
+    };
+
+    std::printf("%-24s %7s %10s %10s %10s %10s\n", "benchmark", "param", "p50 ns", "p99 ns", "p99.9 ns", "allocs/op");
+    for (auto& bench : benches)
+    {
+        if (!filter.empty() && std::string(bench.first).find(filter) == std::string::npos) continue;
+        for (unsigned n = 10; n <= maxParam; n *= 10) bench.second(n);
+    }
+
+    writeJson(json);
+    std::cout << std::endl << "Results written to " << json << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "../OISMHandler.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+using namespace std::chrono;
+
+
+struct ToggleStats
+{
+    std::vector<double> frame; //!< Longest update() while switching, microseconds
+    std::vector<double> latency; //!< Until the switch is applied, microseconds
+};
+
+
+double percentile(std::vector<double> v, double p)
+{
+    if (v.empty()) return 0.;
+    std::sort(v.begin(), v.end());
+    return v[std::min<size_t>(v.size() - 1, v.size() * p)];
+}
+
+
+ToggleStats run(oism::Handler* input, unsigned toggles)
+{
+    ToggleStats stats;
+    for (unsigned i = 0; i < toggles; i++)
+    {
+        auto start = high_resolution_clock::now();
+        input->setExclusive(!input->isExclusive());
+
+        double longest = 0.;
+        do
+        {
+            auto frameStart = high_resolution_clock::now();
+            input->update();
+            longest = std::max(longest,
+                duration_cast<nanoseconds>(high_resolution_clock::now() - frameStart).count() / 1000.);
+        } while (input->isExclusivePending());
+
+        stats.frame.push_back(longest);
+        stats.latency.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1000.);
+    }
+    return stats;
+}
+
+
+void report(const std::string& name, const ToggleStats& stats)
+{
+    std::cout << name << std::endl
+              << "  frame   p50 " << percentile(stats.frame, .5) << " us, max "
+              << percentile(stats.frame, 1.) << " us" << std::endl
+              << "  latency p50 " << percentile(stats.latency, .5) << " us, max "
+              << percentile(stats.latency, 1.) << " us" << std::endl;
+}
+
+
+// Exclusive mode toggle cost on the frame and until applied
+int main(int argc, char** argv)
+{
+    const unsigned toggles = argc > 1 ? std::stoi(argv[1]) : 50;
+
+    auto input = new oism::Handler(testutils::createWindow(), false);
+
+    report("In place toggle", run(input, toggles));
+
+    // Refused switches fall back to recreating the devices
+    input->setExclusiveToggle([](bool){return false;});
+
+    input->setAsyncDeviceCreation(false);
+    report("Recreate on the frame", run(input, toggles));
+
+    input->setAsyncDeviceCreation(true); // XInitThreads() called by createWindow()
+    report("Recreate in background", run(input, toggles));
+
+    delete input;
+    testutils::destroyWindow();
+
+    std::cout << std::endl << "Terminated normally" << std::endl;
+    return 0;
+}
@@ -1,36 +1,48 @@
 #include "../OISMHandler.h"
 #include "../OISMSimpleSerializer.h"
+#include "../OISMSyntheticBackend.h"
 
 #include "TestUtils.h"
 
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
 
 
+using testutils::check;
+
+
+// Tour of the API on the mapping shipped with the sources, devices are scripted
 int main(int argc, char** argv)
 {
+    const std::string path = argc > 1 ? argv[1] : "../";
+
     // Set logger output
     oism::log::set([](const std::string& msg, oism::log::Level lvl)
     {
         std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
     });
 
-    // Create handler & load mapping
-    oism::Handler* input = new oism::Handler(testutils::createWindow());
-    input->load<oism::SimpleSerializer>("../");
+    // Create handler & load mapping, 'Handler(windowID)' for OIS devices
+    auto backend = std::make_shared<oism::SyntheticBackend>();
+    oism::Handler* input = new oism::Handler(backend);
+    input->load<oism::SimpleSerializer>(path);
 
     // ===============
     // Callbacks
     // ===============
     
-    // Callback are disabled when the share pointer is destroyed;
-    oism::Bind::CallbackSharedPtr exit = input->callback("quit",
+    // Callback are disabled when the handle is destroyed;
+    oism::CallbackHandle exit = input->callback("quit",
         [](){testutils::isRunning = false;});
 
+    bool disabledCalled = false;
     {
         // Callback is disable at the end of the scope
-        auto tmp = input->callback("disabled",
-            [](){std::cout<<"disabled!"<<std::endl;});
+        auto tmp = input->callback("quit",
+            [&](){disabledCalled = true;});
     }
 
     // Helper container to create and destroy callbacks
@@ -46,18 +58,46 @@ int main(int argc, char** argv)
     // the value farthest from zero win.
     oism::Bind* walk = input->getBinding("walk");
 
-    while (testutils::isRunning)
+    // Script: walk forward, backward, toggle exclusive mode, then quit
+    unsigned frame = 0;
+    while (testutils::isRunning && frame < 10000)
     {
+        // Devices are recreated by the exclusive mode switch
+        oism::SyntheticKeyboard* keyboard = backend->getKeyboard();
+        oism::SyntheticMouse* mouse = backend->getMouse();
+        switch (frame++)
+        {
+            case 0: keyboard->press(OIS::KC_W); break;
+            case 1:
+                check(walk->getValue() == 1.f, "walk forward");
+                keyboard->release(OIS::KC_W);
+                keyboard->press(OIS::KC_S);
+                break;
+            case 2:
+                check(walk->getValue() == -1.f, "walk backward");
+                keyboard->release(OIS::KC_S);
+                mouse->press(OIS::MB_Right);
+                break;
+            case 3: mouse->release(OIS::MB_Right); break;
+            default:
+                if (input->isExclusivePending()) break;
+                check(!input->isExclusive(), "exclusive mode not toggled");
+                keyboard->press(OIS::KC_ESCAPE);
+                break;
+        }
+
         input->update();
         std::cout<<"walk value="<<walk->getValue();
         std::cout<<"                      \r"<<std::flush; // Keep the same output line
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
-    
+    check(!testutils::isRunning, "quit not called");
+    check(!disabledCalled, "disabled callback called");
+
     // Cleanup
-    input->save<oism::SimpleSerializer>("../");
+    input->save<oism::SimpleSerializer>(path, true);
     delete input;
-    testutils::destroyWindow();
 
-    std::cout << std::endl << "Terminated normally" << std::endl;
-    return 0;
+    std::cout << std::endl;
+    return testutils::result();
 }
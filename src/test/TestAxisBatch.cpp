@@ -0,0 +1,74 @@
+#include "../OISMAxisBatch.h"
+
+#include "TestUtils.h"
+
+#include <OISJoyStick.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+
+
+using testutils::check;
+
+
+// The vectorized kernel against the scalar one
+int main(int argc, char** argv)
+{
+    const unsigned laneCount = 51; // Not a multiple of 4
+    const int maxAxis = OIS::JoyStick::MAX_AXIS;
+
+    oism::AxisBatch simd, scalar;
+    for (unsigned i = 0; i < laneCount; i++)
+    {
+        float deadZone = (i % 5) * .1f;
+        float threshold = (i % 3) * .01f;
+        simd.addLane(i / 8, i % 8, deadZone, threshold);
+        scalar.addLane(i / 8, i % 8, deadZone, threshold);
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> full(-maxAxis - 1, maxAxis);
+    std::uniform_int_distribution<int> noise(-300, 300);
+    unsigned changes = 0;
+    for (unsigned frame = 0; frame < 2000; frame++)
+    {
+        for (unsigned i = 0; i < laneCount; i++)
+        {
+            // Mostly noise, sometimes a full deflection or an end
+            int v = frame % 7 == 0 ? full(rng) : noise(rng);
+            if (frame % 31 == 0) v = (i & 1) ? maxAxis : -maxAxis - 1;
+            simd.setRaw(i, v);
+            scalar.setRaw(i, v);
+        }
+
+        unsigned n = simd.process();
+        if (n != scalar._processScalar() || simd.getChanged() != scalar.getChanged())
+        {
+            check(false, "changed lanes differ at frame " + std::to_string(frame));
+            break;
+        }
+        for (unsigned i = 0; i < laneCount; i++)
+        {
+            float v = simd.getValue(i);
+            if (v != scalar.getValue(i) || v < -1.f || v > 1.f)
+            {
+                check(false, "values differ at frame " + std::to_string(frame));
+                break;
+            }
+        }
+        changes += n;
+    }
+    check(changes > 0, "nothing changed");
+
+    // Dead zone and clamp
+    oism::AxisBatch batch;
+    batch.addLane(0, 0, .5f, 0.f);
+    batch.setRaw(0, maxAxis / 4);
+    check(batch.process() == 0 && batch.getValue(0) == 0.f, "dead zone");
+    batch.setRaw(0, -maxAxis - 1);
+    check(batch.process() == 1 && batch.getValue(0) == -1.f, "clamp");
+
+    std::cout<<changes<<" changes"<<std::endl;
+    return testutils::result();
+}
@@ -0,0 +1,68 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+
+#include "TestUtils.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+
+using testutils::check;
+
+
+const std::string g_path = "cache-test/";
+
+
+// Change a field of the cache header, the header isn't checksummed
+void patchHeader(size_t offset, uint32_t value)
+{
+    std::fstream cache((g_path+"inputmap.cache").c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    cache.seekp(offset);
+    cache.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+// Binary cache of the map file, no window needed
+int main(int argc, char** argv)
+{
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    check(mkdir(g_path.c_str(), 0755) == 0 || errno == EEXIST, "directory not created");
+    std::remove((g_path+"inputmap.cache").c_str());
+    std::ofstream((g_path+"inputmap").c_str(), std::ios::trunc) << "jump keyboard space\nfire mouse left\n";
+
+    typedef oism::SimpleSerializer::CacheHeader CacheHeader;
+    for (unsigned pass = 0; pass < 2; pass++)
+    {
+        oism::NamedBindingMap loaded;
+        oism::SimpleSerializer(g_path).loadBinding(loaded);
+        check(loaded.list.size() == 2 && loaded.getBinding("jump", false)->getKeyEvents().size() == 1,
+            pass ? "bindings not loaded from the cache" : "bindings not loaded");
+        for (auto b : loaded.list) delete b;
+
+        std::ifstream cache((g_path+"inputmap.cache").c_str(), std::ios::binary);
+        CacheHeader header;
+        check(cache.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.bindingCount == 2,
+            "cache not written");
+    }
+
+    // A binding count past the cached bindings, the cache is dropped and
+    // the text parsed, events aren't duplicated
+    patchHeader(offsetof(CacheHeader, bindingCount), 3);
+    oism::NamedBindingMap loaded;
+    oism::SimpleSerializer(g_path).loadBinding(loaded);
+    check(loaded.list.size() == 2 && loaded.getBinding("jump", false)->getKeyEvents().size() == 1,
+        "truncated cache used");
+    for (auto b : loaded.list) delete b;
+
+    return testutils::result();
+}
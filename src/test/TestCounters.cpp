@@ -0,0 +1,66 @@
+#include "../OISMHandler.h"
+#include "../OISMSyntheticBackend.h"
+
+#include "TestUtils.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+using testutils::check;
+
+
+// Hot path counters, built with 'OISM_ENABLE_COUNTERS'
+int main(int argc, char** argv)
+{
+    using namespace oism;
+    using namespace oism::counters;
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    auto backend = std::make_shared<SyntheticBackend>();
+    Handler* input = new Handler(backend, 0, false);
+    input->getBinding("jump", false)->addKeyEvent(KeyEvent::create(OIS::KC_SPACE, 0, false));
+    input->getBinding("run", false)->addKeyEvent(KeyEvent::create(OIS::KC_SPACE, 0, false));
+    input->_buildBindingListMaps();
+    reset();
+
+    unsigned jumps = 0;
+    auto jumpCb = input->callback("jump", [&](){++jumps;});
+    const unsigned count = 100;
+    for (unsigned i = 0; i < count; i++)
+    {
+        backend->getKeyboard()->press(OIS::KC_SPACE);
+        backend->getKeyboard()->press(OIS::KC_SPACE); // Already down
+        backend->getKeyboard()->release(OIS::KC_SPACE);
+        backend->getKeyboard()->press(OIS::KC_W); // Unbound
+        backend->getKeyboard()->release(OIS::KC_W);
+        input->update();
+    }
+    jumpCb.reset();
+    input->_buildBindingListMaps();
+
+    for (unsigned i = 0; i < CNT_COUNT; i++)
+        std::cout<<to_string((Counter)i)<<"="<<get((Counter)i)<<std::endl;
+    check(get(CNT_KEYBOARD_EVENTS) == count * 5, "keyboard events");
+    check(get(CNT_DISPATCH_PROBES) == count * 5, "dispatch probes");
+    check(get(CNT_DISPATCH_MISSES) == count * 2, "dispatch misses");
+    check(get(CNT_SET_VALUE_NOOPS) == count * 2, "set value no-ops");
+    check(get(CNT_CALLBACKS_FIRED) == count && jumps == count, "callbacks fired");
+    check(get(CNT_CALLBACKS_REMOVED) == 1, "callbacks removed");
+    check(get(CNT_REBUILDS) == 1, "rebuilds");
+
+    // Counts of other threads are kept after they exit
+    std::thread([](){ add(CNT_REBUILDS, 10); }).join();
+    check(get(CNT_REBUILDS) == 11, "exited thread");
+    reset();
+    check(get(CNT_REBUILDS) == 0 && get(CNT_KEYBOARD_EVENTS) == 0, "reset");
+
+    delete input;
+
+    return testutils::result();
+}
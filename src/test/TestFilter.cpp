@@ -0,0 +1,115 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+#include "../OISMSyntheticBackend.h"
+
+#include "TestUtils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+
+using testutils::check;
+
+
+bool near(float a, float b) { return std::fabs(a - b) < 1e-4f; }
+
+
+// Output of a single stage chain after 'updates' updates with a constant input
+float run(const oism::FilterStage& stage, float input, unsigned updates = 1)
+{
+    oism::FilterBank bank;
+    bank.add(0, oism::FilterChain(1, stage), 0.f);
+    bank.setInput(0, input);
+    float output = 0.f;
+    for (unsigned i = 0; i < updates; i++)
+        for (auto slot : bank.process()) output = bank.getOutput(slot);
+    return output;
+}
+
+
+// Filter stages, then filtered bindings through the handler and the map file
+int main(int argc, char** argv)
+{
+    using namespace oism;
+    typedef FilterStage FS;
+
+    check(near(run(FS::create(FS::FT_SCALE, 2.f), .25f), .5f), "scale");
+    check(near(run(FS::create(FS::FT_POWER, 2.f), -.5f), -.25f), "power keep the sign");
+    check(near(run(FS::create(FS::FT_BEZIER, 0.f, 1.f), .5f), .5f * .5f * (3.f - 2.f * .5f)), "bezier");
+    check(run(FS::create(FS::FT_BEZIER, .2f, .8f), 1.f) == 1.f, "bezier end");
+    check(near(run(FS::create(FS::FT_ACCEL, 1.f), .5f), .75f), "acceleration");
+    check(near(run(FS::create(FS::FT_SMOOTH, .5f), 1.f), .5f), "smoothing first update");
+    check(near(run(FS::create(FS::FT_SMOOTH, .5f), 1.f, 2), .75f), "smoothing second update");
+    check(run(FS::create(FS::FT_SMOOTH, .5f), 1.f, 100) == 1.f, "smoothing settle");
+    check(near(run(FS::create(FS::FT_RAMP, .25f), 1.f, 2), .5f), "ramp");
+    check(run(FS::create(FS::FT_RAMP, .25f), 1.f, 4) == 1.f, "ramp end");
+
+    // Idle chains aren't evaluated
+    FilterBank bank;
+    bank.add(3, FilterChain(1, FS::create(FS::FT_SMOOTH, .5f)), 0.f);
+    check(!bank.isFiltered(0) && !bank.setInput(0, 1.f), "unfiltered binding");
+    check(bank.process().empty() && bank.process().empty(), "idle chain");
+    bank.setInput(3, 1.f);
+    check(bank.process().size() == 1, "active chain");
+    bank.setInput(3, 0.f);
+    unsigned updates = 0;
+    while (!bank.process().empty()) updates++;
+    check(updates > 1 && updates < 100 && bank.getOutput(0) == 0.f, "chain back to idle");
+
+    // Values are filtered once per update, callbacks follow the raw value
+    auto backend = std::make_shared<SyntheticBackend>();
+    Handler* input = new Handler(backend, 0, false);
+    Bind* walk = input->getBinding("walk", false);
+    walk->addKeyEvent(KeyEvent::create(OIS::KC_W, 0, false));
+    walk->addFilter(FS::create(FS::FT_RAMP, .25f));
+    unsigned pressed = 0;
+    CallbackHandle handle = input->callback("walk", [&pressed](){pressed++;});
+    input->_buildBindingListMaps();
+
+    backend->getKeyboard()->press(OIS::KC_W);
+    input->update();
+    check(near(walk->getValue(), .25f) && pressed == 1, "ramped key");
+    input->update();
+    input->update();
+    input->update();
+    check(walk->getValue() == 1.f, "ramped key end");
+    walk->clearFilters();
+    input->update();
+    check(walk->getValue() == 1.f, "filter removed");
+
+    // Mouse axes get the configured smoothing
+    Bind* look = input->getBinding("look", false);
+    look->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_AXIS_X));
+    input->getConfiguration().mouseSmoothing = .5f;
+    const float sensivity = input->getConfiguration().mouseSensivityAxisX;
+    backend->getMouse()->move(10, 0);
+    input->update();
+    check(near(look->getValue(), 5.f * sensivity), "mouse smoothing");
+    input->update();
+    check(near(look->getValue(), 2.5f * sensivity), "mouse smoothing decay");
+    input->getConfiguration().mouseSmoothing = 0.f;
+    input->update();
+    check(look->getValue() == 0.f, "mouse smoothing disabled");
+
+    // Map file and binary cache
+    look->addFilter(FS::create(FS::FT_POWER, 1.5f));
+    look->addFilter(FS::create(FS::FT_BEZIER, .25f, .75f));
+    system("mkdir -p test-filter-map");
+    remove("test-filter-map/inputmap.cache");
+    input->save<SimpleSerializer>("test-filter-map/");
+    for (unsigned pass = 0; pass < 2; pass++)
+    {
+        Handler loaded;
+        loaded.load<SimpleSerializer>("test-filter-map/");
+        const FilterChain& filters = loaded.getBinding("look", false)->getFilters();
+        check(filters == look->getFilters(), pass ? "filters not loaded from the cache" : "filters not loaded");
+    }
+
+    delete input;
+
+    return testutils::result();
+}
@@ -0,0 +1,87 @@
+#include "../OISMHandler.h"
+#include "../OISMSyntheticBackend.h"
+
+#include "TestUtils.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+using testutils::check;
+
+
+// Update until the scanner applied the change
+bool waitFor(oism::Handler* input, const std::function<bool()>& done)
+{
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done() && std::chrono::steady_clock::now() < timeout)
+    {
+        input->update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
+
+
+// Joysticks connected, disconnected and reconnected through the synthetic backend
+int main(int argc, char** argv)
+{
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    using namespace oism;
+    auto backend = std::make_shared<SyntheticBackend>();
+    Handler* input = new Handler(backend, 0, false);
+
+    Bind* fire = input->getBinding("fire", false);
+    fire->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_Button, 0, 0));
+    Bind* aim = input->getBinding("aim", false);
+    aim->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_Button, 0, 1));
+    input->_buildBindingListMaps();
+
+    input->enableJoyStickHotplug(1);
+
+    // Connect, numbered in order
+    backend->connectJoyStick("Pad");
+    check(waitFor(input, [&](){return input->isJoyStickConnected(0);}), "pad not connected");
+    backend->connectJoyStick("Stick");
+    check(waitFor(input, [&](){return input->isJoyStickConnected(1);}), "stick not connected");
+
+    SyntheticJoyStick* pad = backend->getJoyStick("Pad#0");
+    SyntheticJoyStick* stick = backend->getJoyStick("Stick#0");
+    check(pad && stick, "joysticks not created");
+    if (pad) pad->press(0);
+    if (stick) stick->press(0);
+    input->update();
+    check(fire->getValue() == 1.f && aim->getValue() == 1.f, "connected joysticks not dispatched");
+
+    // Disconnect, the other joystick and its held inputs are kept
+    backend->disconnectJoyStick("Pad#0");
+    check(waitFor(input, [&](){return !input->isJoyStickConnected(0);}), "pad not disconnected");
+    check(fire->getValue() == 0.f, "disconnected pad not released");
+    check(input->isJoyStickConnected(1) && backend->getJoyStick("Stick#0") == stick, "stick recreated");
+    check(aim->getValue() == 1.f, "stick released");
+    if (stick) stick->release(0);
+    input->update();
+    check(aim->getValue() == 0.f, "kept stick not dispatched");
+
+    // Reconnect, the number is back
+    backend->connectJoyStick("Pad");
+    check(waitFor(input, [&](){return input->isJoyStickConnected(0);}), "pad not reconnected");
+    check(!input->isJoyStickConnected(2), "pad got a new number");
+    pad = backend->getJoyStick("Pad#0");
+    check(pad != nullptr, "reconnected pad not created");
+    if (pad) pad->press(0);
+    input->update();
+    check(fire->getValue() == 1.f && aim->getValue() == 0.f, "reconnected pad not dispatched on its number");
+
+    delete input;
+
+    return testutils::result();
+}
@@ -0,0 +1,121 @@
+#include "../OISMHandler.h"
+#include "../OISMSyntheticBackend.h"
+
+#include "TestUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+using testutils::check;
+
+
+void print(const std::string& name, const oism::LatencyHistogram& h)
+{
+    std::cout<<name<<": count="<<h.getCount()<<" mean="<<h.getMean()<<"ns p50="<<h.getPercentile(.5)
+             <<"ns p99="<<h.getPercentile(.99)<<"ns max="<<h.getMax()<<"ns"<<std::endl;
+}
+
+
+// Latency histograms with synthetic devices, built with 'OISM_ENABLE_LATENCY'
+int main(int argc, char** argv)
+{
+    using namespace oism;
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    // Histogram buckets
+    {
+        LatencyHistogram h;
+        for (unsigned long long ns = 1; ns <= 1000000; ns++) h.record(ns);
+        check(h.getCount() == 1000000 && h.getMax() == 1000000, "histogram count");
+        unsigned long long p50 = h.getPercentile(.5);
+        check(p50 >= 500000 && p50 <= 500000 + 500000 / LatencyHistogram::SubBuckets, "histogram percentile");
+        check(h.getPercentile(1.) >= 1000000, "histogram maximum");
+        for (unsigned i = 0; i + 1 < LatencyHistogram::BucketCount; i++)
+            if (LatencyHistogram::index(LatencyHistogram::upperBound(i)) != i ||
+                LatencyHistogram::index(LatencyHistogram::upperBound(i) + 1) != i + 1)
+            {
+                check(false, "histogram bucket " + std::to_string(i));
+                break;
+            }
+        h.reset();
+        check(h.getCount() == 0 && h.getPercentile(.5) == 0, "histogram reset");
+    }
+
+    auto backend = std::make_shared<SyntheticBackend>();
+    Handler* input = new Handler(backend, 0, false);
+    Bind* jump = input->getBinding("jump", false);
+    jump->addKeyEvent(KeyEvent::create(OIS::KC_SPACE, 0, false));
+    Bind* look = input->getBinding("look", false);
+    look->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_AXIS_X));
+    input->_buildBindingListMaps();
+    unsigned jumps = 0;
+    auto jumpCb = input->callback("jump", [&](){++jumps;});
+
+    // Dispatched on update
+    const unsigned count = 1000;
+    for (unsigned i = 0; i < count; i++)
+    {
+        backend->getKeyboard()->press(OIS::KC_SPACE);
+        backend->getKeyboard()->release(OIS::KC_SPACE);
+        backend->getMouse()->move(1, 0);
+        input->update();
+    }
+    // Injected events aren't measured
+    input->injectKey(OIS::KC_SPACE, 0, true);
+    input->injectKey(OIS::KC_SPACE, 0, false);
+
+    print("keyboard value", input->getLatency(LD_KEYBOARD, LT_VALUE));
+    print("keyboard callback", input->getLatency(LD_KEYBOARD, LT_CALLBACK));
+    check(input->getLatency(LD_KEYBOARD, LT_VALUE).getCount() == count * 2, "keyboard value latency");
+    check(input->getLatency(LD_KEYBOARD, LT_CALLBACK).getCount() == count, "keyboard callback latency");
+    check(input->getLatency(LD_MOUSE, LT_VALUE).getCount() == count, "mouse value latency");
+    check(input->getLatency(LD_MOUSE, LT_CALLBACK).getCount() == 0, "mouse callback latency");
+    check(jump->getLatency(LT_CALLBACK).getCount() == count, "binding latency");
+    check(look->getLatency(LT_VALUE).getCount() == count, "binding latency");
+    input->resetLatency();
+    check(input->getLatency(LD_KEYBOARD, LT_VALUE).getCount() == 0 && jump->getLatency(LT_VALUE).getCount() == 0,
+          "latency reset");
+
+    // Threaded, includes the wait for 'update()'
+    std::atomic<unsigned> step(0);
+    input->startThread(10000, [&]()
+    {
+        unsigned i = step.load(std::memory_order_relaxed);
+        if (i >= count * 2) return;
+        SyntheticKeyboard* keyboard = backend->getKeyboard();
+        if (i & 1) keyboard->release(OIS::KC_SPACE);
+        else keyboard->press(OIS::KC_SPACE);
+        keyboard->capture();
+        step.store(i + 1, std::memory_order_release);
+    });
+
+    jumps = 0;
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((step.load(std::memory_order_acquire) < count * 2 || jumps < count) &&
+           std::chrono::steady_clock::now() < timeout)
+    {
+        input->update();
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+    }
+    input->stopThread();
+
+    print("threaded keyboard value", input->getLatency(LD_KEYBOARD, LT_VALUE));
+    print("threaded keyboard callback", input->getLatency(LD_KEYBOARD, LT_CALLBACK));
+    check(jumps == count, "threaded callbacks");
+    check(input->getLatency(LD_KEYBOARD, LT_CALLBACK).getCount() == count, "threaded callback latency");
+    // Values changing between snapshots are measured once
+    unsigned long long values = input->getLatency(LD_KEYBOARD, LT_VALUE).getCount();
+    check(values > 0 && values <= count * 2, "threaded value latency");
+
+    delete input;
+
+    return testutils::result();
+}
@@ -0,0 +1,112 @@
+#include "../OISMHandler.h"
+
+#include "TestUtils.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using testutils::check;
+
+
+std::atomic<unsigned long long> g_allocs(0);
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+
+// Count its formatting
+struct Formatted { unsigned* count; };
+
+template <class Out>
+void append(Out& out, const Formatted& f)
+{
+    ++*f.count;
+    oism::log::append(out, "formatted");
+}
+
+
+// Level filtering and asynchronous sink, no window needed
+int main(int argc, char** argv)
+{
+    using namespace oism;
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    log::set([&](const std::string& msg, log::Level lvl)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(msg);
+    });
+
+    unsigned formatted = 0;
+    log::log(log::Level::Info, "a", 1, ' ', -2, ' ', 3u, ' ', 0.5, ' ', std::string("b"), ' ', Formatted{&formatted});
+    check(messages.size() == 1 && messages[0] == "a1 -2 3 0.5 b formatted" && formatted == 1, "formatting");
+
+    // Discarded before formatting
+    log::setMinLevel(log::Level::Warning);
+    log::log(log::Level::Info, Formatted{&formatted});
+    check(messages.size() == 1 && formatted == 1, "level filtered");
+    log::log(log::Level::Error, Formatted{&formatted});
+    check(messages.size() == 2 && formatted == 2, "level passed");
+    log::setMinLevel(log::Level::Info);
+
+    // Only truncated by the asynchronous sink
+    log::log(log::Level::Info, std::string(1000, 'x'), 1);
+    check(messages.back().size() == 1001, "truncated");
+    log::startAsync(1 << 16);
+    log::log(log::Level::Info, std::string(1000, 'x'));
+    log::stopAsync();
+    check(messages.back().size() == log::Record::TextSize, "async not truncated");
+
+    // Asynchronous, no allocation on the logging thread
+    messages.clear();
+    log::startAsync(1 << 16);
+    const unsigned threadCount = 4;
+    const unsigned count = 10000;
+    unsigned long long allocs = g_allocs.load();
+    log::log(log::Level::Info, "Joystick ", 3, " connected: ", "identity");
+    allocs = g_allocs.load() - allocs;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; t++)
+        threads.push_back(std::thread([t, count]()
+        {
+            for (unsigned i = 0; i < count; i++) log::log(log::Level::Info, "thread ", t, " message ", i);
+        }));
+    for (auto& thread : threads) thread.join();
+    log::stopAsync();
+    check(!log::isAsync(), "async stopped");
+
+    std::cout<<messages.size()<<" messages, "<<allocs<<" allocations"<<std::endl;
+    check(allocs == 0, "async allocation");
+    check(messages.size() == threadCount * count + 1, "async messages");
+    check(!messages.empty() && messages[0] == "Joystick 3 connected: identity", "async message");
+
+    // Order is kept per thread
+    std::vector<long> last(threadCount, -1);
+    for (auto& msg : messages)
+    {
+        unsigned t, i;
+        if (std::sscanf(msg.c_str(), "thread %u message %u", &t, &i) != 2) continue;
+        if (t >= threadCount || (long)i != last[t] + 1)
+        {
+            check(false, "async order");
+            break;
+        }
+        last[t] = i;
+    }
+
+    return testutils::result();
+}
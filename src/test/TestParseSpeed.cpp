@@ -0,0 +1,94 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+
+// Time the input map parser on a generated file, no window needed
+int main(int argc, char** argv)
+{
+    const unsigned lineCount = argc > 1 ? atoi(argv[1]) : 1000000;
+    const unsigned bindingCount = 10000;
+    const std::string path = "parse-speed/";
+
+    // Console output would be timed instead of the parser, only count problems
+    unsigned problems = 0;
+    oism::log::set([&problems](const std::string&, oism::log::Level lvl)
+    {
+        if (lvl != oism::log::Level::Info) ++problems;
+    });
+
+    // Generate the input map
+    system(("mkdir -p "+path).c_str());
+    std::remove((path+"inputmap.cache").c_str());
+    {
+        static const char* lines[] =
+        {
+            "keyboard w -s LShift+Up\n",
+            "Keyboard ctrl+alt+F4\n",
+            "mouse axis_x -axis_y\n",
+            "MOUSE Middle\n",
+            "joystick 0 axis 1\n",
+            "joystick 1 -pov 3\n",
+        };
+        const unsigned lineTypes = sizeof(lines) / sizeof(*lines);
+
+        std::ofstream fs(path+"inputmap", std::ios::trunc);
+        for (unsigned i = 0; i < lineCount; i++)
+            fs << "binding" << i % bindingCount << '\t' << lines[i % lineTypes];
+
+        oism::Handler::Configuration config;
+        oism::SimpleSerializer(path).saveConfig(&config);
+    }
+
+    std::ifstream ifs(path+"inputmap", std::ios::binary | std::ios::ate);
+    double megabytes = ifs.tellg() / (1024. * 1024.);
+
+    using namespace std::chrono;
+
+    // Text parse, write the cache
+    auto startTime = high_resolution_clock::now();
+    {
+        oism::Handler input;
+        input.load<oism::SimpleSerializer>(path);
+    }
+    double parseTime = duration_cast<microseconds>(high_resolution_clock::now() - startTime).count() / 1000000.;
+
+    // Cached load
+    startTime = high_resolution_clock::now();
+    {
+        oism::Handler input;
+        input.load<oism::SimpleSerializer>(path);
+    }
+    double cacheTime = duration_cast<microseconds>(high_resolution_clock::now() - startTime).count() / 1000000.;
+
+    std::cout << lineCount << " lines, " << megabytes << " MB" << std::endl;
+    std::cout << "parse: " << parseTime << " s, " << lineCount / parseTime << " lines/s, "
+              << megabytes / parseTime << " MB/s" << std::endl;
+    std::cout << "cache: " << cacheTime << " s" << std::endl;
+
+    bool ok = !problems;
+    if (problems) std::cout << problems << " warning(s) or error(s) while loading" << std::endl;
+
+    // Numbers past the int range are rejected, not wrapped
+    problems = 0;
+    std::remove((path+"inputmap.cache").c_str());
+    std::ofstream(path+"inputmap", std::ios::trunc) << "wrapped joystick 4294967296 axis 0\n";
+    {
+        oism::Handler input;
+        input.load<oism::SimpleSerializer>(path);
+        if (!input.getBinding("wrapped", false)->getJoyStickEvents().empty() || !problems)
+        {
+            std::cout << "Number out of range accepted" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << std::endl << (ok ? "Terminated normally" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
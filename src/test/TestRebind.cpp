@@ -0,0 +1,85 @@
+#include "../OISMHandler.h"
+
+#include "TestUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+using testutils::check;
+
+
+// Binding edits without rebuilding the dispatch tables, no window needed
+int main(int argc, char** argv)
+{
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    oism::Handler* input = new oism::Handler();
+
+    oism::Bind* jump = input->getBinding("jump", false);
+    jump->addKeyEvent(oism::KeyEvent::create(OIS::KC_SPACE, 0, false));
+    input->_buildBindingListMaps();
+
+    unsigned lands = 0;
+    auto landCb = input->callback("jump", [&](){++lands;}, oism::Bind::CT_ON_CENTER);
+
+    // Added while a key is held
+    input->injectKey(OIS::KC_SPACE, 0, true);
+    jump->addKeyEvent(oism::KeyEvent::create(OIS::KC_J, 0, false));
+    input->injectKey(OIS::KC_J, 0, true);
+    input->injectKey(OIS::KC_SPACE, 0, false);
+    check(jump->getValue() == 1.f, "added key not dispatched");
+
+    // Removing the held key release the binding
+    jump->removeKeyEvent(oism::KeyEvent::create(OIS::KC_J, 0, false));
+    check(jump->getValue() == 0.f && lands == 1, "removed key still held");
+    input->injectKey(OIS::KC_J, 0, false);
+    input->injectKey(OIS::KC_J, 0, true);
+    check(jump->getValue() == 0.f, "removed key dispatched");
+
+    // Batched edits are applied when the scope ends
+    oism::Bind* walk = input->getBinding("walk", false);
+    {
+        oism::BatchEdit batch(input);
+        walk->addKeyEvent(oism::KeyEvent::create(OIS::KC_W, 0, false));
+        walk->addKeyEvent(oism::KeyEvent::create(OIS::KC_S, 0, true));
+        input->injectKey(OIS::KC_W, 0, true);
+        check(walk->getValue() == 0.f, "batched edit applied early");
+    }
+    input->injectKey(OIS::KC_W, 0, false);
+    input->injectKey(OIS::KC_S, 0, true);
+    check(walk->getValue() == -1.f, "batched edit not applied");
+    input->injectKey(OIS::KC_S, 0, false);
+
+    // Threaded, edits are applied by the input thread
+    std::atomic<bool> pressed(false);
+    input->startThread(2000, [&]()
+    {
+        input->injectKey(OIS::KC_A, 0, pressed.load());
+    });
+    {
+        oism::BatchEdit batch(input);
+        walk->removeKeyEvent(oism::KeyEvent::create(OIS::KC_S, 0, true));
+        walk->addKeyEvent(oism::KeyEvent::create(OIS::KC_A, 0, true));
+    }
+    pressed = true;
+
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (walk->getValue() != -1.f && std::chrono::steady_clock::now() < timeout)
+    {
+        input->update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(walk->getValue() == -1.f, "threaded edit not applied");
+
+    input->stopThread();
+    delete input;
+
+    return testutils::result();
+}
@@ -0,0 +1,91 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+const std::string g_path = "reload-test/";
+
+
+// Replace the map the way editors do, write then rename
+void writeMap(const std::string& content)
+{
+    std::ofstream((g_path+"inputmap.new").c_str(), std::ios::trunc) << content;
+    std::rename((g_path+"inputmap.new").c_str(), (g_path+"inputmap").c_str());
+}
+
+
+// Hot reload of the map file, no window needed
+int main(int argc, char** argv)
+{
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    if (mkdir(g_path.c_str(), 0755) && errno != EEXIST)
+    {
+        std::cout<<"Could not create '"<<g_path<<"'"<<std::endl;
+        return 1;
+    }
+    std::remove((g_path+"inputmap.cache").c_str());
+    writeMap("jump keyboard space\nfire mouse left\n");
+
+    oism::Handler* input = new oism::Handler();
+    input->load<oism::SimpleSerializer>(g_path);
+    input->watch<oism::SimpleSerializer>(g_path);
+
+    oism::Bind* jump = input->getBinding("jump");
+    oism::Bind* fire = input->getBinding("fire");
+    unsigned jumps = 0;
+    auto jumpCb = input->callback("jump", [&](){++jumps;});
+
+    // Rebind jump, remove fire
+    writeMap("jump keyboard j\n");
+
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (jump->getKeyEvents().size() != 1 ||
+           jump->getKeyEvents()[0] != oism::KeyEvent::create(OIS::KC_J, 0, false))
+    {
+        if (std::chrono::steady_clock::now() > timeout) break;
+        input->update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    input->update(); // Apply dispatch patch
+
+    bool ok = true;
+    if (input->getBinding("jump") != jump || !jump->getKeyEvents().size())
+    {
+        std::cout<<"Binding not reloaded"<<std::endl;
+        ok = false;
+    }
+    if (!fire->getMouseEvents().empty())
+    {
+        std::cout<<"Removed binding still bound"<<std::endl;
+        ok = false;
+    }
+
+    // Old key unbound, new key dispatched to the same callback
+    input->injectKey(OIS::KC_SPACE, 0, true);
+    input->injectKey(OIS::KC_SPACE, 0, false);
+    input->injectKey(OIS::KC_J, 0, true);
+    input->update();
+    if (jump->getValue() != 1.f || jumps != 1)
+    {
+        std::cout<<"Invalid dispatch after reload, value="<<jump->getValue()<<" jumps="<<jumps<<std::endl;
+        ok = false;
+    }
+
+    delete input;
+
+    std::cout<<(ok ? "Terminated normally" : "FAILED")<<std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "../OISMHandler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+const char* g_path = "replay-test.rec";
+const char* g_names[] = {"look", "zoom", "fire", "throttle", "hat", "jump"};
+const unsigned g_nameCount = sizeof(g_names) / sizeof(*g_names);
+
+
+void bindAll(oism::Handler* input)
+{
+    using namespace oism;
+    input->getBinding("look", false)->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_AXIS_X));
+    input->getBinding("zoom", false)->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_AXIS_Z));
+    input->getBinding("fire", false)->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_LEFT));
+    input->getBinding("throttle", false)->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_Axis, 1, 0));
+    input->getBinding("hat", false)->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_POV, 1, 0));
+    input->getBinding("jump", false)->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_Button, 2, 0));
+    input->_buildBindingListMaps();
+}
+
+
+void snapshot(oism::Handler* input, std::vector<float>& values)
+{
+    for (unsigned i = 0; i < g_nameCount; i++) values.push_back(input->getBinding(g_names[i], false)->getValue());
+}
+
+
+// Device events recorded then replayed without devices, no window needed
+int main(int argc, char** argv)
+{
+    const unsigned frameCount = argc > 1 ? std::stoi(argv[1]) : 2000;
+
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    // Record, events go through the listener interfaces like device events
+    std::vector<float> recorded;
+    unsigned eventCount = 0;
+    {
+        oism::Handler input;
+        bindAll(&input);
+        input.startRecording(g_path);
+        input.update();
+
+        OIS::MouseListener& mouse = input;
+        oism::JoyStickListener joyListener(&input, 0);
+        OIS::JoyStickListener& joystick = joyListener;
+
+        OIS::MouseState mouseState;
+        OIS::JoyStickState joyState;
+        joyState.mAxes.resize(2);
+        unsigned seed = 12345;
+        for (unsigned f = 0; f < frameCount; f++)
+        {
+            unsigned events = f % 4;
+            for (unsigned e = 0; e < events; e++, eventCount++)
+            {
+                seed = seed * 1103515245 + 12345;
+                unsigned r = seed >> 16;
+                switch (r % 6)
+                {
+                    case 0:
+                        mouseState.X.rel = (int)(r % 41) - 20;
+                        mouseState.Z.rel = r & 1 ? 120 : 0;
+                        mouse.mouseMoved(OIS::MouseEvent(nullptr, mouseState));
+                        break;
+                    case 1: mouse.mousePressed(OIS::MouseEvent(nullptr, mouseState), OIS::MB_Left); break;
+                    case 2: mouse.mouseReleased(OIS::MouseEvent(nullptr, mouseState), OIS::MB_Left); break;
+                    case 3:
+                        joyState.mAxes[1].abs = (int)(r % 65536) - 32768;
+                        joystick.axisMoved(OIS::JoyStickEvent(nullptr, joyState), 1);
+                        break;
+                    case 4:
+                        joyState.mPOV[0].direction = r & 1 ? OIS::Pov::NorthEast : OIS::Pov::Centered;
+                        joystick.povMoved(OIS::JoyStickEvent(nullptr, joyState), 0);
+                        break;
+                    case 5:
+                        if (r & 1) joystick.buttonPressed(OIS::JoyStickEvent(nullptr, joyState), 2);
+                        else joystick.buttonReleased(OIS::JoyStickEvent(nullptr, joyState), 2);
+                        break;
+                }
+            }
+            input.update();
+            snapshot(&input, recorded);
+        }
+
+        input.stopRecording();
+        input.update();
+    }
+
+    // Replay on a handler with the same bindings
+    std::vector<float> replayed;
+    oism::Player player(g_path);
+    {
+        oism::Handler input;
+        bindAll(&input);
+        while (player.playFrame(&input))
+        {
+            input.update();
+            snapshot(&input, replayed);
+        }
+    }
+
+    // The update applying 'stopRecording()' recorded an empty frame
+    bool ok = player.isOpen() && replayed.size() >= recorded.size() &&
+              std::equal(recorded.begin(), recorded.end(), replayed.begin());
+    if (!ok) std::cout<<"Replay differ, "<<replayed.size()<<" values for "<<recorded.size()<<std::endl;
+
+    std::FILE* file = std::fopen(g_path, "rb");
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    std::cout<<eventCount<<" events, "<<frameCount<<" frames, "<<size<<" bytes"<<std::endl;
+
+    std::cout<<(ok ? "Terminated normally" : "FAILED")<<std::endl;
+    return ok ? 0 : 1;
+}
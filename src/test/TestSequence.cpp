@@ -0,0 +1,196 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+#include "../OISMSyntheticBackend.h"
+
+#include "TestUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+using testutils::check;
+
+
+typedef std::vector<std::vector<unsigned>> Steps;
+
+
+// Automaton, then sequence bindings through the handler and the map file
+int main(int argc, char** argv)
+{
+    using namespace oism;
+
+    // Overlapping sequences, only the ones within their window complete
+    SequenceMatcher matcher;
+    matcher.add(0, Steps{{1}, {2}, {3}}, 100);
+    matcher.add(1, Steps{{2}, {3}}, 100);
+    matcher.add(2, Steps{{1}, {2}, {3}}, 10);
+    matcher.compile();
+    check(!matcher.isSymbol(4) && matcher.press(4, 0).empty(), "unused binding");
+    matcher.press(1, 0);
+    matcher.press(2, 20000);
+    auto& done = matcher.press(3, 40000);
+    check(done.size() == 2 && std::count(done.begin(), done.end(), 0) && std::count(done.begin(), done.end(), 1),
+        "overlapping sequences");
+    check(matcher.press(3, 41000).empty(), "completed sequences held");
+    check(matcher.release(1).empty() && matcher.release(3).size() == 2, "released by the last step");
+    matcher.press(1, 200000);
+    matcher.press(2, 250000);
+    check(matcher.press(3, 301000).size() == 1, "window");
+
+    // Chords complete in any order, not with a press in between
+    SequenceMatcher chords;
+    chords.add(7, Steps{{1}, {2, 3, 4}}, 100);
+    chords.compile();
+    chords.press(1, 0);
+    chords.press(4, 1000);
+    chords.press(2, 2000);
+    check(chords.press(3, 3000).size() == 1, "chord order");
+    chords.release(2);
+    chords.press(1, 10000);
+    chords.press(4, 11000);
+    chords.press(1, 12000);
+    chords.press(2, 13000);
+    check(chords.press(3, 14000).empty(), "broken chord");
+
+    // Many sequences, a few lookups per press
+    SequenceMatcher many;
+    const unsigned count = 5000;
+    for (unsigned i = 0; i < count; i++) many.add(i, Steps{{i % 20}, {i / 20 % 20}, {i / 400 % 20}, {20}}, 500);
+    many.compile();
+    unsigned completed = 0;
+    for (unsigned i = 0; i < 100000; i++) completed += many.press((i * 2654435761u >> 16) % 21, i).size();
+    check(completed > 0 && many.getStateCount() <= count * 4 + 1, "many sequences");
+
+    // Transitions grow with the sequences, not with the bindings they use
+    SequenceMatcher wide;
+    const unsigned wideCount = 2000;
+    for (unsigned i = 0; i < wideCount; i++) wide.add(i, Steps{{2 * i}, {2 * i + 1}}, 100);
+    wide.compile();
+    wide.press(2 * 1234, 0);
+    auto& wideDone = wide.press(2 * 1234 + 1, 1);
+    check(wideDone.size() == 1 && wideDone[0] == 1234 && wide.getTransitionCount() == 2 * wideCount, "wide alphabet");
+
+    // Bindings, a sequence is pressed until a binding of its last step is released
+    auto backend = std::make_shared<SyntheticBackend>();
+    Handler* input = new Handler(backend, 0, false);
+    input->getBinding("down", false)->addKeyEvent(KeyEvent::create(OIS::KC_S, 0, false));
+    input->getBinding("forward", false)->addKeyEvent(KeyEvent::create(OIS::KC_D, 0, false));
+    input->getBinding("punch", false)->addKeyEvent(KeyEvent::create(OIS::KC_J, 0, false));
+    Bind* special = input->getBinding("special", false);
+    BindSequence sequence(200);
+    sequence.steps = {{"down"}, {"forward", "punch"}};
+    special->addSequence(sequence);
+    unsigned fired = 0;
+    CallbackHandle handle = input->callback("special", [&fired](){fired++;});
+    input->_buildBindingListMaps();
+    input->update();
+
+    SyntheticKeyboard* keyboard = backend->getKeyboard();
+    keyboard->press(OIS::KC_S);
+    keyboard->release(OIS::KC_S);
+    keyboard->press(OIS::KC_J);
+    keyboard->press(OIS::KC_D);
+    input->update();
+    check(special->getValue() == 1.f && fired == 1, "sequence not pressed");
+    keyboard->release(OIS::KC_D);
+    input->update();
+    check(special->getValue() == 0.f, "sequence not released");
+    keyboard->release(OIS::KC_J);
+
+    keyboard->press(OIS::KC_S);
+    keyboard->release(OIS::KC_S);
+    input->update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    keyboard->press(OIS::KC_D);
+    keyboard->press(OIS::KC_J);
+    input->update();
+    check(special->getValue() == 0.f && fired == 1, "sequence window");
+    keyboard->release(OIS::KC_D);
+    keyboard->release(OIS::KC_J);
+
+    special->clearSequences();
+    input->update();
+    keyboard->press(OIS::KC_S);
+    keyboard->press(OIS::KC_D);
+    keyboard->press(OIS::KC_J);
+    input->update();
+    check(special->getValue() == 0.f, "sequence removed");
+    keyboard->release(OIS::KC_S);
+    keyboard->release(OIS::KC_D);
+    keyboard->release(OIS::KC_J);
+    input->update();
+
+    // Steps without input are reported
+    unsigned warnings = 0;
+    log::set([&warnings](const std::string&, log::Level lvl){if (lvl == log::Level::Warning) ++warnings;});
+    BindSequence typo(200);
+    typo.steps = {{"down"}, {"forwrad"}};
+    special->addSequence(typo);
+    input->update();
+#ifdef OISM_ENABLE_LOG
+    check(warnings == 1, "step binding without input not reported");
+#endif
+    log::set(nullptr);
+    special->clearSequences();
+
+    // Replayed with the recorded times, the windows fail and complete the same
+    special->addSequence(sequence);
+    input->startRecording("test-sequence.rec");
+    input->update();
+    keyboard->press(OIS::KC_S);
+    keyboard->release(OIS::KC_S);
+    input->update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    keyboard->press(OIS::KC_D);
+    keyboard->press(OIS::KC_J);
+    input->update();
+    keyboard->release(OIS::KC_D);
+    keyboard->release(OIS::KC_J);
+    keyboard->press(OIS::KC_S);
+    keyboard->release(OIS::KC_S);
+    keyboard->press(OIS::KC_D);
+    keyboard->press(OIS::KC_J);
+    input->update();
+    keyboard->release(OIS::KC_D);
+    keyboard->release(OIS::KC_J);
+    input->update();
+    input->stopRecording();
+    input->update();
+    check(fired == 2, "recorded sequences");
+    {
+        Handler replayed;
+        replayed.getBinding("down", false)->addKeyEvent(KeyEvent::create(OIS::KC_S, 0, false));
+        replayed.getBinding("forward", false)->addKeyEvent(KeyEvent::create(OIS::KC_D, 0, false));
+        replayed.getBinding("punch", false)->addKeyEvent(KeyEvent::create(OIS::KC_J, 0, false));
+        replayed.getBinding("special", false)->addSequence(sequence);
+        unsigned replayedFired = 0;
+        CallbackHandle replayedHandle = replayed.callback("special", [&replayedFired](){replayedFired++;});
+        replayed._buildBindingListMaps();
+        replayed.update();
+
+        Player player("test-sequence.rec");
+        while (player.playFrame(&replayed)) replayed.update();
+        check(player.isOpen() && replayedFired == 1, "sequence windows not replayed");
+    }
+
+    // Map file and binary cache
+    system("mkdir -p test-sequence-map");
+    remove("test-sequence-map/inputmap.cache");
+    input->save<SimpleSerializer>("test-sequence-map/");
+    for (unsigned pass = 0; pass < 2; pass++)
+    {
+        Handler loaded;
+        loaded.load<SimpleSerializer>("test-sequence-map/");
+        check(loaded.getBinding("special", false)->getSequences() == special->getSequences(),
+            pass ? "sequences not loaded from the cache" : "sequences not loaded");
+    }
+
+    delete input;
+
+    return testutils::result();
+}
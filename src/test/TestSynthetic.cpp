@@ -0,0 +1,211 @@
+#include "../OISMHandler.h"
+#include "../OISMSimpleSerializer.h"
+#include "../OISMSyntheticBackend.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using testutils::check;
+
+
+unsigned g_errors = 0;
+
+
+// Rewrite a config file as an older version without 'keys'
+void dropKeys(const std::string& filename, const std::vector<std::string>& keys)
+{
+    std::ifstream in(filename);
+    std::string text, line;
+    while (std::getline(in, line))
+    {
+        if (std::find(keys.begin(), keys.end(), line.substr(0, line.find(' '))) == keys.end())
+            text += line + '\n';
+    }
+    in.close();
+    std::ofstream(filename) << text;
+}
+
+
+// Scripted devices through the device dispatch, no window needed
+int main(int argc, char** argv)
+{
+    const unsigned eventCount = argc > 1 ? std::stoi(argv[1]) : 1000000;
+
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        if (lvl == oism::log::Level::Error) g_errors++;
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    auto backend = std::make_shared<oism::SyntheticBackend>(2);
+    oism::Handler* input = new oism::Handler(backend, 0, false);
+
+    using namespace oism;
+    Bind* jump = input->getBinding("jump", false);
+    jump->addKeyEvent(KeyEvent::create(OIS::KC_SPACE, OIS::Keyboard::Shift, false));
+    Bind* walk = input->getBinding("walk", false);
+    walk->addKeyEvent(KeyEvent::create(OIS::KC_W, 0, false));
+    Bind* fire = input->getBinding("fire", false);
+    fire->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_LEFT));
+    Bind* look = input->getBinding("look", false);
+    look->addMouseEvent(MouseEvent::create(MouseEvent::CPNT_AXIS_X));
+    Bind* throttle = input->getBinding("throttle", false);
+    throttle->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_Axis, 0, 1));
+    Bind* trigger = input->getBinding("trigger", false);
+    trigger->addJoyStickEvent(JoyStickEvent::create(OIS::OIS_Button, 0, 1));
+    input->_buildBindingListMaps();
+
+    // Modifiers come from the keyboard state
+    SyntheticKeyboard* keyboard = backend->getKeyboard();
+    keyboard->press(OIS::KC_LSHIFT);
+    keyboard->press(OIS::KC_SPACE);
+    input->update();
+    check(jump->getValue() == 1.f, "key with modifier not dispatched");
+    keyboard->release(OIS::KC_SPACE);
+    keyboard->release(OIS::KC_LSHIFT);
+    input->update();
+    check(jump->getValue() == 0.f, "key with modifier not released");
+
+    backend->getMouse()->press(OIS::MB_Left);
+    backend->getMouse()->move(10, 0);
+    input->update();
+    check(fire->getValue() == 1.f && look->getValue() > 0.f, "mouse not dispatched");
+
+    backend->getJoyStick(1)->moveAxis(0, OIS::JoyStick::MAX_AXIS);
+    input->update();
+    check(throttle->getValue() == 1.f, "joystick not dispatched");
+
+    // Motion of a capture is summed, listeners still see every event
+    struct MoveCounter : public OIS::MouseListener
+    {
+        MoveCounter() : moves(0) {}
+        unsigned moves;
+        bool mouseMoved(const OIS::MouseEvent&) { ++moves; return true; }
+        bool mousePressed(const OIS::MouseEvent&, OIS::MouseButtonID) { return true; }
+        bool mouseReleased(const OIS::MouseEvent&, OIS::MouseButtonID) { return true; }
+    } moveCounter;
+    input->addMouseListener(&moveCounter);
+    input->getConfiguration().mouseCoalesce = true;
+    const float sensivity = input->getConfiguration().mouseSensivityAxisX;
+    for (unsigned i = 0; i < 8; i++) backend->getMouse()->move(1, 0);
+    input->update();
+    check(std::fabs(look->getValue() - 8 * sensivity) < 1e-5f && moveCounter.moves == 8, "mouse motion not coalesced");
+    input->update();
+    check(look->getValue() == 0.f, "coalesced mouse motion not cleared");
+    input->getConfiguration().mouseCoalesce = false;
+    input->removeMouseListener(&moveCounter);
+
+    // Axis noise is filtered before dispatch
+    Handler::Configuration& config = input->getConfiguration();
+    config.joystickAxisFilter = Handler::Configuration::AxisFilter(0.1f, 0.01f);
+    config.joystickAxisFilters.push_back({1, 0, Handler::Configuration::AxisFilter(0.5f, 0.01f)});
+    SyntheticJoyStick* stick = backend->getJoyStick(1);
+    const int maxAxis = OIS::JoyStick::MAX_AXIS;
+    stick->moveAxis(0, maxAxis / 4);
+    input->update();
+    check(throttle->getValue() == 0.f, "axis dead zone");
+    stick->moveAxis(0, maxAxis * 3 / 4);
+    input->update();
+    check(std::fabs(throttle->getValue() - .5f) < .01f, "axis dead zone not rescaled");
+    float before = throttle->getValue();
+    stick->moveAxis(0, maxAxis * 3 / 4 + 100);
+    input->update();
+    check(throttle->getValue() == before, "axis threshold");
+    stick->moveAxis(0, maxAxis);
+    input->update();
+    check(throttle->getValue() == 1.f, "axis end");
+
+    // Same filtering with the batch
+    config.joystickBatchAxes = true;
+    stick->moveAxis(0, maxAxis / 4);
+    stick->moveAxis(0, maxAxis * 3 / 4); // Only the last value is read
+    input->update();
+    check(std::fabs(throttle->getValue() - .5f) < .01f, "batch axis dead zone");
+    stick->moveAxis(0, -maxAxis);
+    input->update();
+    check(throttle->getValue() == -1.f, "batch axis end");
+
+    // Axes are laid out again on filter changes, held buttons are kept
+    stick->press(0);
+    input->update();
+    config.joystickAxisFilter = Handler::Configuration::AxisFilter(0.2f, 0.01f);
+    input->update();
+    check(trigger->getValue() == 1.f && throttle->getValue() == -1.f, "filter change released the joystick");
+    stick->release(0);
+    input->update();
+
+    // Saved and loaded
+    system("mkdir -p test-synthetic-map");
+    input->save<SimpleSerializer>("test-synthetic-map/");
+    Handler loaded;
+    loaded.load<SimpleSerializer>("test-synthetic-map/");
+    check(loaded.getConfiguration() == config, "configuration not loaded");
+    config = Handler::Configuration();
+
+    // Optional keys missing from an older file keep their default
+    SimpleSerializer serializer("test-synthetic-map/");
+    Handler::Configuration older;
+    serializer.saveConfig(&older);
+    dropKeys("test-synthetic-map/inputconf", {"mouse_coalesce", "joystick_dead_zone", "joystick_threshold", "joystick_axis_filters", "joystick_batch_axes"});
+    const unsigned errors = g_errors;
+    serializer.loadConfig(&older);
+    check(g_errors == errors && older == Handler::Configuration(), "optional keys not optional");
+
+    // Devices are recreated, bindings keep working
+    input->setExclusive(true);
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    do
+    {
+        input->update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } while (input->isExclusivePending() && std::chrono::steady_clock::now() < timeout);
+    check(!input->isExclusivePending() && backend->getKeyboard() != keyboard, "devices not recreated");
+    backend->getKeyboard()->press(OIS::KC_W);
+    input->update();
+    check(walk->getValue() == 1.f, "recreated keyboard not dispatched");
+    backend->getKeyboard()->release(OIS::KC_W);
+
+    // Switched in place, devices are kept
+    keyboard = backend->getKeyboard();
+    bool toggled = true;
+    input->setExclusiveToggle([&](bool exclusive){toggled = exclusive; return true;});
+    input->setExclusive(false);
+    input->update();
+    check(!input->isExclusivePending() && !toggled && backend->getKeyboard() == keyboard, "not switched in place");
+    input->setExclusiveToggle(nullptr);
+
+    // Throughput
+    using namespace std::chrono;
+    const unsigned batch = 1000;
+    auto startTime = high_resolution_clock::now();
+    for (unsigned sent = 0; sent < eventCount; sent += batch)
+    {
+        keyboard = backend->getKeyboard();
+        SyntheticJoyStick* joystick = backend->getJoyStick(1);
+        for (unsigned i = 0; i < batch; i += 4)
+        {
+            keyboard->press(OIS::KC_W);
+            keyboard->release(OIS::KC_W);
+            joystick->moveAxis(0, i * 8);
+            joystick->moveAxis(1, -(int)i);
+        }
+        input->update();
+    }
+    double seconds = duration_cast<microseconds>(high_resolution_clock::now() - startTime).count() / 1000000.;
+    std::cout<<eventCount<<" events, "<<eventCount / seconds<<" events/s"<<std::endl;
+
+    delete input;
+
+    return testutils::result();
+}
@@ -0,0 +1,71 @@
+#include "../OISMHandler.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+// Threaded mode with synthetic events, no window needed
+int main(int argc, char** argv)
+{
+    oism::log::set([](const std::string& msg, oism::log::Level lvl)
+    {
+        std::cout<<"oism | "<<oism::log::to_string(lvl)<<msg<<std::endl;
+    });
+
+    // Handler without input system
+    oism::Handler* input = new oism::Handler();
+
+    input->getBinding("jump", false)->addKeyEvent(oism::KeyEvent::create(OIS::KC_SPACE, 0, false));
+    oism::Bind* walk = input->getBinding("walk", false);
+    walk->addKeyEvent(oism::KeyEvent::create(OIS::KC_W, 0, false));
+    walk->addKeyEvent(oism::KeyEvent::create(OIS::KC_S, 0, true));
+    input->_buildBindingListMaps();
+
+    const unsigned jumpCount = 500;
+    unsigned jumps = 0;
+    unsigned lands = 0;
+    auto jumpCb = input->callback("jump", [&](){++jumps;});
+    auto landCb = input->callback("jump", [&](){++lands;}, oism::Bind::CT_ON_CENTER);
+
+    // Called on the input thread
+    std::atomic<unsigned> step(0);
+    input->startThread(10000, [&]()
+    {
+        unsigned i = step.load(std::memory_order_relaxed);
+        if (i >= jumpCount * 2) return;
+
+        input->injectKey(OIS::KC_SPACE, 0, !(i & 1));
+        // Walk back and forth, both keys are down on odd steps
+        input->injectKey(OIS::KC_W, 0, i % 4 == 0 || i % 4 == 1);
+        input->injectKey(OIS::KC_S, 0, i % 4 == 1 || i % 4 == 2);
+
+        step.store(i + 1, std::memory_order_release);
+    });
+
+    // Game loop
+    bool valid = true;
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((step.load(std::memory_order_acquire) < jumpCount * 2 || lands < jumpCount) &&
+           std::chrono::steady_clock::now() < timeout)
+    {
+        input->update();
+
+        float v = walk->getValue();
+        if (v != 0.f && v != 1.f && v != -1.f) valid = false;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+    }
+
+    input->stopThread();
+    delete input;
+
+    std::cout<<"jumps="<<jumps<<" lands="<<lands<<" expected="<<jumpCount<<std::endl;
+    if (!valid) std::cout<<"Invalid binding value"<<std::endl;
+
+    bool ok = valid && jumps == jumpCount && lands == jumpCount;
+    std::cout<<(ok ? "Terminated normally" : "FAILED")<<std::endl;
+    return ok ? 0 : 1;
+}
@@ -38,6 +38,7 @@ void checkMacEvents();
 
 // Initialize test
 bool testutils::isRunning = true;
+bool g_ok = true;
 
 #if defined OIS_WIN32_PLATFORM
 LRESULT DlgProc( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam )
@@ -113,6 +114,8 @@ unsigned long testutils::createWindow()
     return hWnd;    
 
 #elif defined OIS_LINUX_PLATFORM
+    //Devices can be created on a background thread, see 'Handler::setAsyncDeviceCreation()'
+    XInitThreads();
     //Connects to default X window
     if( !(xDisp = XOpenDisplay(0)) )
         OIS_EXCEPT(OIS::E_General, "Error opening X!");
@@ -187,3 +190,18 @@ void testutils::destroyWindow()
     XCloseDisplay(xDisp);
 #endif
 }
+
+
+void testutils::check(bool cond, const std::string& msg)
+{
+    if (cond) return;
+    std::cout<<"Failed: "<<msg<<std::endl;
+    g_ok = false;
+}
+
+
+int testutils::result()
+{
+    std::cout<<(g_ok ? "Terminated normally" : "FAILED")<<std::endl;
+    return g_ok ? 0 : 1;
+}
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <string>
+
 namespace testutils
 {
 
+/// Print 'msg' if 'cond' is false, the test then fails
+void check(bool cond, const std::string& msg);
+/// Print the outcome of the checks, return the exit code of the test
+int result();
+
 unsigned long createWindow();
 void destroyWindow();
 extern bool isRunning;